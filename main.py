@@ -1,10 +1,13 @@
 from pydantic import ValidationError
 from fastapi import FastAPI, Depends, HTTPException, Form
-from fastapi.responses import HTMLResponse
-from model import FactorRequest, FactorResponse, OptsType, LLLOptions
-from utils.std_parse import parse_output, parse_output_html
+from fastapi.responses import HTMLResponse, StreamingResponse
+from model import FactorRequest, FactorResponse, JobResponse, OptsType, LLLOptions
+from utils.std_parse import parse_output, parse_output_json, parse_output_html, format_factor
+from utils.factor_cache import FactorCache
+from utils.jobs import JobManager, QueueFullError, ProcessError, run_command
 import uvicorn
-import subprocess
+import json
+import os
 
 
 tags_metadata = [
@@ -16,6 +19,7 @@ tags_metadata = [
             "url": "https://github.com/geodavic/poly_factor",
         },
     },
+    {"name": "jobs", "description": "Submit long factorizations and follow their progress"},
     {"name": "web", "description": "Endpoints for the Web UI"},
 ]
 app = FastAPI(
@@ -29,28 +33,47 @@ app = FastAPI(
     openapi_tags=tags_metadata,
 )
 
+# Factorization cache (POLY_FACTOR_CACHE_DB enables the on-disk store)
+factor_cache = FactorCache(
+    max_entries=int(os.environ.get("POLY_FACTOR_CACHE_SIZE", 1024)),
+    db_path=os.environ.get("POLY_FACTOR_CACHE_DB"),
+)
+
+
+def cache_complete_result(poly, response):
+    """Cache the factors of a finished job, unless it stopped early (then they are only partial)."""
+    if response["complete"]:
+        factor_cache.put([int(c) for c in poly.split(",")], response["coefficients"])
+
+
+# Job queue for /jobs, and CPU time limit (seconds) for every run of lll_factor
+CPU_LIMIT = int(os.environ.get("POLY_FACTOR_CPU_LIMIT", 60))
+job_manager = JobManager(
+    max_workers=int(os.environ.get("POLY_FACTOR_WORKERS", os.cpu_count() or 1)),
+    max_jobs=int(os.environ.get("POLY_FACTOR_MAX_JOBS", 64)),
+    cpu_limit=CPU_LIMIT,
+    parse=parse_output_json,
+    on_result=cache_complete_result,
+)
 
-def base_factor(poly: str, opts: OptsType, verbose=False):
+
+async def base_factor(poly: str, opts: OptsType, verbose=False, json=False):
     """Base LLL request processor"""
     # Get data from request
-    command = opts.to_list(poly)
+    command = opts.to_list(poly, json=json)
 
-    # Execute
+    # Execute (without blocking the event loop)
     print(command, flush=True)
-    proc = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
-    stdout, stderr = proc.communicate()
-    exit_code = proc.wait()
-
-    # Catch C-level errors
-    if exit_code == 1:
+    try:
+        return await run_command(command, cpu_limit=CPU_LIMIT)
+    except ProcessError as e:
+        # Catch C-level errors
         if verbose:
-            detail = stdout.decode("utf-8")+"\n"+stderr.decode("utf-8")
+            detail = e.stdout + "\n" + e.detail
         else:
-            detail = stderr.decode("utf-8")
+            detail = e.detail
         raise HTTPException(status_code=500, detail=detail)
 
-    return stdout.decode("utf-8")
-
 
 @app.post(
     "/factor",
@@ -62,9 +85,79 @@ def base_factor(poly: str, opts: OptsType, verbose=False):
 async def factor(request: FactorRequest):
     """Factor a polynomial and return result as json response."""
 
-    out = base_factor(request.poly, request.opts)
-    response = parse_output(out)
-    return FactorResponse(factors=response["factors"], time=response["time"])
+    coefs = [int(c) for c in request.poly.split(",")]
+    cached = factor_cache.get(coefs)
+    if cached is not None:
+        factors = [format_factor(c, m) for c, m in cached]
+        return FactorResponse(factors=factors, time="0ms", cached=True)
+
+    # strip off known irreducible factors, only run LLL on what is left
+    found, cofactor = factor_cache.trial_divide(coefs)
+    response = {"time": "0ms", "complete": True, "cofactor": None}
+    if len(cofactor) > 1:
+        out = await base_factor(",".join(map(str, cofactor)), request.opts, json=True)
+        response = parse_output_json(out)
+        found += response["coefficients"]
+    elif cofactor != [1]:
+        found.append((cofactor, 1))  # content of a non-monic input
+
+    # partial results (timeout reached) are returned but not cached
+    if response["complete"]:
+        factor_cache.put(coefs, found)
+    factors = [format_factor(c, m) for c, m in found]
+    return FactorResponse(
+        factors=factors,
+        time=response["time"],
+        complete=response["complete"],
+        cofactor=response["cofactor"],
+    )
+
+
+@app.post("/jobs", tags=["jobs"], responses={200: {"model": JobResponse}})
+async def submit_job(request: FactorRequest):
+    """Submit a factorization job. Poll it at /jobs/{id} or stream /jobs/{id}/events."""
+
+    command = request.opts.to_list(request.poly, json=True, progress=True)
+    try:
+        job = job_manager.submit(request.poly, command)
+    except QueueFullError as e:
+        raise HTTPException(status_code=503, detail=str(e))
+    return JobResponse(**job.summary())
+
+
+@app.get("/jobs/{job_id}", tags=["jobs"], responses={200: {"model": JobResponse}})
+async def poll_job(job_id: str):
+    """Status, latest progress event and (once done) result of a job."""
+
+    job = job_manager.get(job_id)
+    if job is None:
+        raise HTTPException(status_code=404, detail="No such job")
+    return JobResponse(**job.summary())
+
+
+@app.get("/jobs/{job_id}/events", tags=["jobs"])
+async def stream_job(job_id: str):
+    """Stream progress events of a job as server-sent events, ending with its summary."""
+
+    job = job_manager.get(job_id)
+    if job is None:
+        raise HTTPException(status_code=404, detail="No such job")
+
+    async def events():
+        async for event in job.stream():
+            yield f"data: {json.dumps(event)}\n\n"
+
+    return StreamingResponse(events(), media_type="text/event-stream")
+
+
+@app.delete("/jobs/{job_id}", tags=["jobs"], responses={200: {"model": JobResponse}})
+async def cancel_job(job_id: str):
+    """Cancel a queued or running job."""
+
+    job = await job_manager.cancel(job_id)
+    if job is None:
+        raise HTTPException(status_code=404, detail="No such job")
+    return JobResponse(**job.summary())
 
 
 @app.post("/lll_form_data_factor", tags=["web"])
@@ -82,7 +175,7 @@ async def lll_form_data_factor(
     try:
         opts = LLLOptions(**opts_kw)
         rq = FactorRequest(poly=poly, opts=opts)
-        out = base_factor(rq.poly, rq.opts, verbose=True)
+        out = await base_factor(rq.poly, rq.opts, verbose=True)
     except ValidationError as e:
         failed = True
         out = str(e)
@@ -56,3 +56,15 @@ class LLLFormData(BaseModel, extra=Extra.allow):
 class FactorResponse(BaseModel):
     factors: list
     time: str
+    cached: bool = False
+    complete: bool = True
+    cofactor: Optional[str] = None
+
+
+class JobResponse(BaseModel):
+    id: str
+    status: str
+    events: int
+    progress: Optional[dict] = None
+    result: Optional[dict] = None
+    error: Optional[str] = None
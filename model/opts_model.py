@@ -5,46 +5,81 @@ including their parameters and default values.
 
 from pydantic import BaseModel, validator
 from typing import Union, Optional
+import os
 import sys
 import inspect
 
-ALLOWED_ALGS = ["LLL"]
+ALLOWED_ALGS = ["LLL", "PSLQ"]
 DEFAULT_ALG = "LLL"
 MAX_DEG = 300
 LLL_CAP = 20
+FACTOR_DB = "data/factor_db.bin"
+TUNE_TABLE = "data/tune_table.txt"
 
 
 class LLLOptions(BaseModel):
     alg = "LLL"
-    precision: Optional[int] = 64
-    delta: Optional[float] = 0.5
+    precision: Optional[int] = None  # None: chosen by lll_factor (tuning table if present, else its default)
+    delta: Optional[float] = None
+    timeout: Optional[int] = None  # milliseconds, after which partial results are returned
+    seed: Optional[int] = None  # of the random starting points of root finding, to reproduce a run
+    block: Optional[int] = None  # segment LLL: lattices of at least 2*block vectors are reduced in threaded segments first
 
-    def to_list(cls, input_polynomial: str):
-        """Return the command used to run this algorithm."""
+    def to_list(cls, input_polynomial: str, json: bool = False, progress: bool = False):
+        """Return the command used to run this algorithm.
+        If json is set, ask for structured output instead of the verbose log.
+        If progress is set, progress events are printed on stderr."""
+        output_flags = ["-json"] if json else ["-v", "-newline"]
+        if progress:
+            output_flags.append("-progress")
+        extra_flags = ["-db", FACTOR_DB] if os.path.exists(FACTOR_DB) else []
+        if cls.precision is not None:
+            extra_flags += ["-p", str(cls.precision)]
+        if cls.delta is not None:
+            extra_flags += ["-d", str(cls.delta)]
+        if (cls.precision is None or cls.delta is None) and os.path.exists(TUNE_TABLE):
+            extra_flags += ["-tune", TUNE_TABLE]
+        if cls.timeout is not None:
+            extra_flags += ["-timeout", str(cls.timeout)]
+        if cls.seed is not None:
+            extra_flags += ["-seed", str(cls.seed)]
+        if cls.block is not None:
+            extra_flags += ["-block", str(cls.block)]
         return [
             "./bin/lll_factor",
             str(input_polynomial),
-            "-d",
-            str(cls.delta),
-            "-p",
-            str(cls.precision),
             "-t",
-            "-v",
-            "-newline",
+            *output_flags,
+            *extra_flags,
             "-stop",
             str(LLL_CAP),
         ]
 
     @validator("precision")
     def precision_in_range(cls, precision):
-        assert precision >= 32, "Must have at least 32 bits of precision"
+        assert precision is None or precision >= 32, "Must have at least 32 bits of precision"
         return precision
 
     @validator("delta")
     def delta_in_range(cls, delta):
-        assert delta > 0.25 and delta < 1, "delta parameter must be in (0.25,1)"
+        assert delta is None or (delta > 0.25 and delta < 1), "delta parameter must be in (0.25,1)"
         return delta
 
+    @validator("timeout")
+    def timeout_positive(cls, timeout):
+        assert timeout is None or timeout > 0, "timeout must be a positive number of milliseconds"
+        return timeout
+
+    @validator("seed")
+    def seed_nonnegative(cls, seed):
+        assert seed is None or seed >= 0, "seed must be a nonnegative integer"
+        return seed
+
+    @validator("block")
+    def block_at_least_two(cls, block):
+        assert block is None or block >= 2, "block must be at least 2 vectors"
+        return block
+
     @validator("alg")
     def alg_match(cls, alg, values):
         assert alg in ALLOWED_ALGS, f"Unrecognized algorithm {alg}"
@@ -52,6 +87,60 @@ class LLLOptions(BaseModel):
         return alg
 
 
+class PSLQOptions(BaseModel):
+    alg = "PSLQ"
+    precision: Optional[int] = None  # None: chosen by lll_factor (tuning table if present, else its default)
+    timeout: Optional[int] = None  # milliseconds, after which partial results are returned
+    seed: Optional[int] = None  # of the random starting points of root finding, to reproduce a run
+
+    def to_list(cls, input_polynomial: str, json: bool = False, progress: bool = False):
+        """Return the command used to run this algorithm (lll_factor with minimal polynomials found by PSLQ)."""
+        output_flags = ["-json"] if json else ["-v", "-newline"]
+        if progress:
+            output_flags.append("-progress")
+        extra_flags = ["-db", FACTOR_DB] if os.path.exists(FACTOR_DB) else []
+        if cls.precision is not None:
+            extra_flags += ["-p", str(cls.precision)]
+        elif os.path.exists(TUNE_TABLE):
+            extra_flags += ["-tune", TUNE_TABLE]
+        if cls.timeout is not None:
+            extra_flags += ["-timeout", str(cls.timeout)]
+        if cls.seed is not None:
+            extra_flags += ["-seed", str(cls.seed)]
+        return [
+            "./bin/lll_factor",
+            str(input_polynomial),
+            "-t",
+            *output_flags,
+            *extra_flags,
+            "-alg",
+            "pslq",
+            "-stop",
+            str(LLL_CAP),
+        ]
+
+    @validator("precision")
+    def precision_in_range(cls, precision):
+        assert precision is None or precision >= 32, "Must have at least 32 bits of precision"
+        return precision
+
+    @validator("timeout")
+    def timeout_positive(cls, timeout):
+        assert timeout is None or timeout > 0, "timeout must be a positive number of milliseconds"
+        return timeout
+
+    @validator("seed")
+    def seed_nonnegative(cls, seed):
+        assert seed is None or seed >= 0, "seed must be a nonnegative integer"
+        return seed
+
+    @validator("alg")
+    def alg_match(cls, alg, values):
+        assert alg in ALLOWED_ALGS, f"Unrecognized algorithm {alg}"
+        assert alg == "PSLQ", "Mismatching options for specified algorithm"
+        return alg
+
+
 """
 Auto-create OptType and DefaultOption
 """
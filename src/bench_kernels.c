@@ -0,0 +1,346 @@
+/*
+
+   Microbenchmarks for the kernels of lll_gs.h and lll_functions.h.
+
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include "lll_gs.h" //includes gmp.h, mpfr.h, mpc.h, math.h
+#include "lll_functions.h" //function library for polynomials
+
+//---------about----------------//
+//times each kernel in isolation on the lattices find_factor_cx builds: alpha is a root of the (irreducible) polynomial
+//x^deg-x-1, found with rootfind_cx, and the basis is create_basis_cx on the powers of alpha with rad from root_radius_cx, i.e.
+//deg+1 vectors of dimension deg+3. every kernel is run for each degree and precision in the lists below.
+//each benchmark repeats its kernel until min_time has passed and prints the mean time per call, in the spirit of
+//google benchmark: BM_<kernel>/<degree>/<precision>  <time per call>  <calls>
+
+//----------notes---------------//
+//the polynomial kernels (polydivide, gcd, mod_screen) don't use floats, so they are only run once per degree.
+//LLL modifies its input, so each call starts from a fresh copy of the basis (included in the time, it is negligible).
+//the first call is a warm up; if it alone takes longer than min_time (e.g. LLL in high degree), it is the measurement.
+//compile with the same flags as lll_factor, so that the numbers are comparable.
+
+typedef struct {
+    int deg;
+    int PRECISION;
+    int dim; //deg+3
+    int nvec; //deg+1
+    mpc_t alpha; //root of x^deg-x-1
+    mpfr_t rad; //its radius (root_radius_cx)
+    power_table powers; //its powers, as find_factor_cx keeps them
+    mpz_t *basis; //lattice of find_factor_cx
+    mpz_t *work; //copy of basis for kernels that modify it
+    mpf_t *obasis; //gram schmidt of basis
+    mpf_t *proj; //output of project_zf
+    mpf_t g_coef; //output of gram_coef
+    mpf_t delta; //LLL parameter
+    int len; //length of the polynomials below (2*deg+2)
+    mpz_t *p; //d*q
+    mpz_t *d; //x^deg-x-1
+    mpz_t *q; //quotient output
+    mpz_t *sq; //d^2*(x+1), for gcd
+    mpz_t *sq_prime; //derivative of sq
+    mpz_t *g; //gcd output
+    mpz_t *bad; //x^deg+(2^40+1)*(x^(deg-1)+...+1), doesn't divide p (like most LLL candidates)
+    mod_screen screen; //residues of p
+} bench_state;
+
+typedef void (*bench_fn)(bench_state *);
+
+void bench_setup(bench_state *st, int deg, int PRECISION);
+void bench_clear(bench_state *st);
+void bench_run(const char *name, bench_fn fn, bench_state *st, double min_time, const char *filter);
+void poly_mul(mpz_t *a, mpz_t *b, mpz_t *out, int len);
+void bm_gram_schmidt(bench_state *st);
+void bm_gram_coef(bench_state *st);
+void bm_project_zf(bench_state *st);
+void bm_lll(bench_state *st);
+void bm_create_basis_cx(bench_state *st);
+void bm_evaluate_cx(bench_state *st);
+void bm_polydivide(bench_state *st);
+void bm_gcd(bench_state *st);
+void bm_polydivide_reject(bench_state *st);
+void bm_mod_screen(bench_state *st);
+void bm_mod_screen_reject(bench_state *st);
+
+
+int main(int argc, char *argv[]){
+    int degrees[]={4,8,12,16};
+    int precisions[]={64,128,256,512};
+    int n_deg=sizeof(degrees)/sizeof(int),n_prec=sizeof(precisions)/sizeof(int);
+    int i,j,k;
+    double min_time=0.2; //seconds per benchmark
+    const char *filter=NULL; //only run benchmarks whose name contains this
+    bench_state st;
+
+    for(i=1;i<argc;i++){
+        if(strcmp(argv[i],"-filter")==0&&i+1<argc)
+            filter=argv[++i];
+        else if(strcmp(argv[i],"-min_time")==0&&i+1<argc)
+            min_time=strtod(argv[++i],NULL);
+        else{
+            fprintf(stderr,"Usage: %s [-filter <substring>] [-min_time <seconds>]\n",argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-40s %14s %10s\n","Benchmark","Time/call","Calls");
+    for(i=0;i<n_deg;i++){
+        for(j=0;j<n_prec;j++){
+            bench_setup(&st,degrees[i],precisions[j]);
+            bench_run("gram_schmidt",bm_gram_schmidt,&st,min_time,filter);
+            bench_run("gram_coef",bm_gram_coef,&st,min_time,filter);
+            bench_run("project_zf",bm_project_zf,&st,min_time,filter);
+            bench_run("LLL",bm_lll,&st,min_time,filter);
+            bench_run("create_basis_cx",bm_create_basis_cx,&st,min_time,filter);
+            bench_run("evaluate_cx",bm_evaluate_cx,&st,min_time,filter);
+            if(j==0){
+                k=st.PRECISION;
+                st.PRECISION=0; //printed as such, these don't depend on it
+                bench_run("polydivide",bm_polydivide,&st,min_time,filter);
+                bench_run("gcd",bm_gcd,&st,min_time,filter);
+                bench_run("polydivide_reject",bm_polydivide_reject,&st,min_time,filter);
+                bench_run("mod_screen",bm_mod_screen,&st,min_time,filter);
+                bench_run("mod_screen_reject",bm_mod_screen_reject,&st,min_time,filter);
+                st.PRECISION=k;
+            }
+            bench_clear(&st);
+        }
+    }
+    return 0;
+}
+
+//build the lattice and polynomials for one degree and precision
+void bench_setup(bench_state *st, int deg, int PRECISION){
+    int i;
+    mpz_t *f; //x^deg-x-1, length deg+1
+    mpz_t *lin; //1+x+...+x^deg, then 1+x
+    mpc_t start;
+
+    st->deg=deg;
+    st->PRECISION=PRECISION;
+    st->dim=deg+3;
+    st->nvec=deg+1;
+    st->len=2*deg+2;
+
+    //alpha: root of x^deg-x-1 at the working precision
+    f=malloc((deg+1)*sizeof(mpz_t));
+    for(i=0;i<deg+1;i++)
+        mpz_init(f[i]);
+    mpz_set_si(f[0],-1);
+    mpz_set_si(f[1],-1);
+    mpz_set_si(f[deg],1);
+    mpc_init2(st->alpha,PRECISION);
+    mpc_init2(start,PRECISION);
+    mpc_set_d_d(start,0.13,-1.023,MPC_RNDNN); //same starting value as find_factor_cx
+    if(!rootfind_cx(f,deg+1,start,st->alpha,(int)(PRECISION*log10(2.0)),PRECISION,NULL))
+        fprintf(stderr,"warning: rootfind_cx did not converge for degree %d\n",deg);
+    mpc_clear(start);
+    mpfr_init2(st->rad,64);
+    root_radius_cx(f,deg+1,st->alpha,st->rad,PRECISION);
+    power_table_init(&st->powers,st->alpha,deg,PRECISION);
+
+    //lattice
+    st->basis=malloc(st->dim*st->nvec*sizeof(mpz_t));
+    st->work=malloc(st->dim*st->nvec*sizeof(mpz_t));
+    st->obasis=mpf_array_init(st->dim*st->nvec,PRECISION); //as in LLL_ctl
+    st->proj=malloc(st->dim*sizeof(mpf_t));
+    for(i=0;i<st->dim*st->nvec;i++){
+        mpz_init2(st->basis[i],PRECISION+GMP_NUMB_BITS); //as in find_factor_cx
+        mpz_init(st->work[i]);
+    }
+    for(i=0;i<st->dim;i++)
+        mpf_init2(st->proj[i],PRECISION);
+    mpf_init2(st->g_coef,PRECISION);
+    mpf_init2(st->delta,PRECISION);
+    mpf_set_d(st->delta,0.5);
+    create_basis_cx(st->basis,&st->powers,st->rad,deg);
+    gram_schmidt(0,st->dim,st->nvec,st->basis,st->obasis,PRECISION);
+
+    //polynomials: p=d*q with d=x^deg-x-1, q=x^deg+...+1; sq=d^2*(x+1)
+    st->p=malloc(st->len*sizeof(mpz_t));
+    st->d=malloc(st->len*sizeof(mpz_t));
+    st->q=malloc(st->len*sizeof(mpz_t));
+    st->sq=malloc(st->len*sizeof(mpz_t));
+    st->sq_prime=malloc(st->len*sizeof(mpz_t));
+    st->g=malloc(st->len*sizeof(mpz_t));
+    st->bad=malloc(st->len*sizeof(mpz_t));
+    lin=malloc(st->len*sizeof(mpz_t));
+    for(i=0;i<st->len;i++){
+        mpz_init(st->p[i]);
+        mpz_init(st->d[i]);
+        mpz_init(st->q[i]);
+        mpz_init(st->sq[i]);
+        mpz_init(st->sq_prime[i]);
+        mpz_init(st->g[i]);
+        mpz_init(st->bad[i]);
+        if(i<deg){
+            mpz_set_ui(st->bad[i],1);
+            mpz_mul_2exp(st->bad[i],st->bad[i],40);
+            mpz_add_ui(st->bad[i],st->bad[i],1);
+        }
+        else if(i==deg)
+            mpz_set_ui(st->bad[i],1);
+        mpz_init(lin[i]);
+        mpz_set_ui(lin[i],i<=deg);
+        if(i<deg+1)
+            mpz_set(st->d[i],f[i]);
+    }
+    poly_mul(st->d,lin,st->p,st->len); //p=d*(1+x+...+x^deg)
+    for(i=0;i<st->len;i++)
+        mpz_set_ui(lin[i],i<2);
+    poly_mul(st->d,st->d,st->q,st->len);
+    poly_mul(st->q,lin,st->sq,st->len); //sq=d^2*(x+1)
+    derivative(st->sq,st->sq_prime,st->len);
+    mod_screen_init(&st->screen,st->p,st->len);
+
+    for(i=0;i<st->len;i++)
+        mpz_clear(lin[i]);
+    free(lin);
+    for(i=0;i<deg+1;i++)
+        mpz_clear(f[i]);
+    free(f);
+}
+
+void bench_clear(bench_state *st){
+    int i;
+    for(i=0;i<st->dim*st->nvec;i++){
+        mpz_clear(st->basis[i]);
+        mpz_clear(st->work[i]);
+    }
+    for(i=0;i<st->dim;i++)
+        mpf_clear(st->proj[i]);
+    for(i=0;i<st->len;i++){
+        mpz_clear(st->p[i]);
+        mpz_clear(st->d[i]);
+        mpz_clear(st->q[i]);
+        mpz_clear(st->sq[i]);
+        mpz_clear(st->sq_prime[i]);
+        mpz_clear(st->g[i]);
+        mpz_clear(st->bad[i]);
+    }
+    free(st->basis);
+    free(st->work);
+    mpf_array_clear(st->obasis,st->dim*st->nvec);
+    free(st->proj);
+    free(st->p);
+    free(st->d);
+    free(st->q);
+    free(st->sq);
+    free(st->sq_prime);
+    free(st->g);
+    free(st->bad);
+    mod_screen_clear(&st->screen);
+    mpf_clear(st->g_coef);
+    mpf_clear(st->delta);
+    mpc_clear(st->alpha);
+    mpfr_clear(st->rad);
+    power_table_clear(&st->powers);
+}
+
+//call fn until min_time seconds have passed (doubling the batch size each round) and print the mean time per call
+void bench_run(const char *name, bench_fn fn, bench_state *st, double min_time, const char *filter){
+    char label[64];
+    long calls=0,batch=1,i;
+    double start,elapsed=0;
+
+    snprintf(label,sizeof(label),"BM_%s/%d/%d",name,st->deg,st->PRECISION);
+    if(filter!=NULL&&strstr(label,filter)==NULL)
+        return;
+
+    start=monotonic_seconds();
+    fn(st); //warm up (and let gmp allocate)
+    elapsed=monotonic_seconds()-start;
+    if(elapsed>=min_time)
+        calls=1; //slow enough, keep it
+    else
+        elapsed=0;
+    while(elapsed<min_time){
+        start=monotonic_seconds();
+        for(i=0;i<batch;i++)
+            fn(st);
+        elapsed+=monotonic_seconds()-start;
+        calls+=batch;
+        batch*=2;
+    }
+
+    if(elapsed/calls>=1e-3)
+        printf("%-40s %11.3f ms %10ld\n",label,1e3*elapsed/calls,calls);
+    else
+        printf("%-40s %11.3f us %10ld\n",label,1e6*elapsed/calls,calls);
+    fflush(stdout);
+}
+
+//out=a*b, truncated to len coefficients (out must not be a or b)
+void poly_mul(mpz_t *a, mpz_t *b, mpz_t *out, int len){
+    int i,j;
+    for(i=0;i<len;i++)
+        mpz_set_ui(out[i],0);
+    for(i=0;i<len;i++){
+        if(mpz_sgn(a[i])==0)
+            continue;
+        for(j=0;i+j<len;j++)
+            mpz_addmul(out[i+j],a[i],b[j]);
+    }
+}
+
+//full recomputation, as at the start of LLL
+void bm_gram_schmidt(bench_state *st){
+    gram_schmidt(0,st->dim,st->nvec,st->basis,st->obasis,st->PRECISION);
+}
+
+//the coefficient of the last vector on the one before it
+void bm_gram_coef(bench_state *st){
+    gram_coef(st->dim,st->nvec-1,st->nvec-2,st->basis,st->obasis,st->g_coef,st->PRECISION);
+}
+
+void bm_project_zf(bench_state *st){
+    project_zf(st->dim,&st->basis[(st->nvec-1)*st->dim],&st->obasis[(st->nvec-2)*st->dim],st->proj,st->PRECISION);
+}
+
+void bm_lll(bench_state *st){
+    int i;
+    for(i=0;i<st->dim*st->nvec;i++)
+        mpz_set(st->work[i],st->basis[i]);
+    LLL(st->dim,st->nvec,st->work,st->delta,st->PRECISION);
+}
+
+void bm_create_basis_cx(bench_state *st){
+    create_basis_cx(st->work,&st->powers,st->rad,st->deg);
+}
+
+//p(alpha) for p of degree 2*deg
+void bm_evaluate_cx(bench_state *st){
+    mpc_t out; mpc_init2(out,st->PRECISION);
+    evaluate_cx(st->p,st->len,st->alpha,out,st->PRECISION);
+    mpc_clear(out);
+}
+
+//exact division of a degree 2*deg polynomial by one of degree deg
+void bm_polydivide(bench_state *st){
+    polydivide(st->p,st->d,st->q,st->len);
+}
+
+//gcd(p,p') for p=d^2*(x+1), as in factorize_full
+void bm_gcd(bench_state *st){
+    gcd(st->sq,st->sq_prime,st->g,st->len);
+}
+
+//polydivide on a candidate that doesn't divide p: the quotient's coefficients grow with every step
+void bm_polydivide_reject(bench_state *st){
+    polydivide(st->p,st->bad,st->q,st->len);
+}
+
+//screen of d as a divisor of p, as find_factor_cx does before polydivide (d divides p: every prime is checked)
+void bm_mod_screen(bench_state *st){
+    mod_screen_divides(&st->screen,st->d,st->len);
+}
+
+//screen of a candidate that doesn't divide p
+void bm_mod_screen_reject(bench_state *st){
+    mod_screen_divides(&st->screen,st->bad,st->len);
+}
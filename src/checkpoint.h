@@ -0,0 +1,286 @@
+//---------about-----------------//
+
+//checkpoints of a long factorization, so that it can continue after the process is killed (e.g. on a preempted machine).
+//factorize() records the polynomial it was given, the factors found so far and the quotient left to factor;
+//find_factor_cx() adds the root it is working on and the last degree LLL searched on it without finding a factor.
+//a resumed run adds the saved factors, and goes on with the quotient from the next degree on the same root.
+
+//---------notes-----------------//
+
+//file format (little-endian, integers as in the -bin format, see write_bin_poly):
+//    "PFCK", u32 version, u32 precision, u32 delta*10^9
+//    the polynomial given to factorize, u32 number of factors found, each factor, the quotient (same length as the polynomial)
+//    u32 last degree searched (0 if none), u32 1 if a root follows (0 if not), then the root as a binary polynomial of
+//    length 4: m_re, e_re, m_im, e_im (root = m_re*2^e_re + i*m_im*2^e_im)
+//the file is written to <path>.tmp and then renamed, so being killed while saving leaves the previous checkpoint.
+//the root and degree are only reused at the same precision and delta; otherwise the search restarts on the quotient
+
+#include <errno.h>
+#include <string.h>
+
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_INTERVAL 60 //default seconds between saves
+
+typedef struct {
+    const char *path; //file to save to
+    double interval; //seconds between saves
+    double last_save; //monotonic_seconds() of the last save (or of checkpoint_init)
+    int resume; //a loaded checkpoint waits for checkpoint_begin
+    int PRECISION; //parameters of the run
+    double delta;
+    int len; //length of start and rest
+    mpz_t *start; //polynomial given to factorize (NULL until known)
+    mpz_t *rest; //quotient read from the file (NULL if none)
+    factor_list found; //factors read from the file
+    mpz_t *poly; //quotient being factored (factorize's array)
+    const factor_list *fl; //factors found so far: fl[first],...
+    int first;
+    int deg_done; //last degree LLL searched on root without finding a factor, 0 if none
+    int has_root; //root is a root of poly
+    mpc_t root;
+} checkpoint;
+
+void checkpoint_init(checkpoint *ck, const char *path, double interval, int PRECISION, double delta);
+void checkpoint_clear(checkpoint *ck);
+mpz_t *checkpoint_poly_alloc(int len);
+void checkpoint_poly_free(mpz_t *p, int len);
+int checkpoint_save(checkpoint *ck);
+int checkpoint_load(checkpoint *ck);
+int checkpoint_begin(checkpoint *ck, mpz_t *poly, int len, factor_list *fl);
+void checkpoint_tick(checkpoint *ck);
+void checkpoint_next(checkpoint *ck);
+int checkpoint_get_root(checkpoint *ck, mpc_t root);
+void checkpoint_set_root(checkpoint *ck, const mpc_t root);
+void checkpoint_degree(checkpoint *ck, int deg);
+
+//set up checkpoints to path, saved at most every interval seconds, for a run with the given parameters
+void checkpoint_init(checkpoint *ck, const char *path, double interval, int PRECISION, double delta){
+    ck->path=path;
+    ck->interval=interval;
+    ck->last_save=monotonic_seconds();
+    ck->resume=0;
+    ck->PRECISION=PRECISION;
+    ck->delta=delta;
+    ck->len=0;
+    ck->start=NULL;
+    ck->rest=NULL;
+    factor_list_init(&ck->found,4,16);
+    ck->poly=NULL;
+    ck->fl=NULL;
+    ck->first=0;
+    ck->deg_done=0;
+    ck->has_root=0;
+    mpc_init2(ck->root,PRECISION);
+}
+
+void checkpoint_clear(checkpoint *ck){
+    checkpoint_poly_free(ck->start,ck->len);
+    checkpoint_poly_free(ck->rest,ck->len);
+    factor_list_clear(&ck->found);
+    mpc_clear(ck->root);
+}
+
+//allocate a zero polynomial of length len
+mpz_t *checkpoint_poly_alloc(int len){
+    int i;
+    mpz_t *p=malloc(len*sizeof(mpz_t));
+    for(i=0;i<len;i++)
+        mpz_init(p[i]);
+    return p;
+}
+
+void checkpoint_poly_free(mpz_t *p, int len){
+    int i;
+    if(p==NULL)
+        return;
+    for(i=0;i<len;i++)
+        mpz_clear(p[i]);
+    free(p);
+}
+
+//write the current state to ck->path (nothing until factorize has started). return 0 on failure
+int checkpoint_save(checkpoint *ck){
+    int j,ok;
+    char *tmp;
+    FILE *f;
+    mpz_t r[4];
+
+    if(ck==NULL||ck->start==NULL)
+        return 0;
+    ck->last_save=monotonic_seconds();
+    tmp=malloc(strlen(ck->path)+5);
+    sprintf(tmp,"%s.tmp",ck->path);
+    f=fopen(tmp,"wb");
+    if(f==NULL){
+        fprintf(stderr,"Could not write checkpoint file %s\n",tmp);
+        free(tmp);
+        return 0;
+    }
+    fwrite("PFCK",1,4,f);
+    write_u32(f,CHECKPOINT_VERSION);
+    write_u32(f,(unsigned long)ck->PRECISION);
+    write_u32(f,(unsigned long)(ck->delta*1e9+0.5));
+    ok=write_bin_poly(f,ck->len,ck->start);
+    write_u32(f,(unsigned long)(ck->fl->count-ck->first));
+    for(j=ck->first;j<ck->fl->count&&ok;j++)
+        ok=write_bin_poly(f,ck->fl->degree[j]+1,factor_coefs(ck->fl,j));
+    ok=ok&&write_bin_poly(f,ck->len,ck->poly);
+    write_u32(f,(unsigned long)ck->deg_done);
+    write_u32(f,(unsigned long)ck->has_root);
+    if(ck->has_root){
+        for(j=0;j<4;j++)
+            mpz_init(r[j]);
+        mpz_set_si(r[1],mpfr_get_z_2exp(r[0],mpc_realref(ck->root)));
+        mpz_set_si(r[3],mpfr_get_z_2exp(r[2],mpc_imagref(ck->root)));
+        ok=ok&&write_bin_poly(f,4,r);
+        for(j=0;j<4;j++)
+            mpz_clear(r[j]);
+    }
+    ok=ok&&!ferror(f);
+    ok=(fclose(f)==0)&&ok;
+    if(!ok||rename(tmp,ck->path)!=0){
+        fprintf(stderr,"Could not write checkpoint file %s\n",ck->path);
+        remove(tmp);
+        free(tmp);
+        return 0;
+    }
+    free(tmp);
+    return 1;
+}
+
+//read the checkpoint at ck->path (after checkpoint_init). it is used by the first checkpoint_begin on the same polynomial
+//return 1 if loaded, -1 if there is no such file, 0 if it is invalid
+int checkpoint_load(checkpoint *ck){
+    int j,len=0,flen,ok;
+    unsigned long version,precision,delta,count=0,deg_done=0,has_root=0;
+    char magic[4];
+    mpz_t *p=NULL;
+    FILE *f=fopen(ck->path,"rb");
+
+    ck->resume=0;
+    if(f==NULL){
+        if(errno==ENOENT)
+            return -1;
+        fprintf(stderr,"Could not open checkpoint file %s\n",ck->path);
+        return 0;
+    }
+    ok=fread(magic,1,4,f)==4&&memcmp(magic,"PFCK",4)==0&&read_u32(f,&version)&&version==CHECKPOINT_VERSION
+        &&read_u32(f,&precision)&&read_u32(f,&delta)&&(len=read_bin_len(f))>0;
+    if(ok){
+        ck->len=len;
+        ck->start=checkpoint_poly_alloc(len);
+        ck->rest=checkpoint_poly_alloc(len);
+        p=checkpoint_poly_alloc(MAX(len,4)); //(also holds the root)
+        ok=read_bin_poly(f,ck->start,len)&&read_u32(f,&count);
+    }
+    for(j=0;ok&&j<(int)count;j++){
+        flen=read_bin_len(f);
+        ok=flen>0&&flen<=len&&read_bin_poly(f,p,flen)&&degree(p,flen)>0;
+        if(ok)
+            factor_list_add(&ck->found,p,degree(p,flen),1);
+    }
+    ok=ok&&read_bin_len(f)==len&&read_bin_poly(f,ck->rest,len)&&read_u32(f,&deg_done)&&read_u32(f,&has_root);
+    if(ok&&has_root){
+        ok=read_bin_len(f)==4&&read_bin_poly(f,p,4)&&mpz_fits_slong_p(p[1])&&mpz_fits_slong_p(p[3]);
+        if(ok){
+            //the root may have been found to more bits than PRECISION (see find_factor_cx): keep all of them
+            mpc_set_prec(ck->root,MAX(ck->PRECISION,(int)MAX(mpz_sizeinbase(p[0],2),mpz_sizeinbase(p[2],2))));
+            mpfr_set_z_2exp(mpc_realref(ck->root),p[0],mpz_get_si(p[1]),MPFR_RNDN);
+            mpfr_set_z_2exp(mpc_imagref(ck->root),p[2],mpz_get_si(p[3]),MPFR_RNDN);
+        }
+    }
+    fclose(f);
+    checkpoint_poly_free(p,MAX(len,4));
+    if(!ok){
+        fprintf(stderr,"Invalid checkpoint file %s\n",ck->path);
+        checkpoint_poly_free(ck->start,ck->len);
+        checkpoint_poly_free(ck->rest,ck->len);
+        ck->start=ck->rest=NULL;
+        factor_list_truncate(&ck->found,0);
+        return 0;
+    }
+
+    //the search on the root depends on the parameters, the factors and quotient don't
+    if((int)precision==ck->PRECISION&&delta==(unsigned long)(ck->delta*1e9+0.5)){
+        ck->deg_done=(int)deg_done;
+        ck->has_root=has_root!=0;
+    }
+    else
+        fprintf(stderr,"Checkpoint was saved with another precision or delta, restarting the search on its quotient.\n");
+    ck->resume=1;
+    return 1;
+}
+
+//start checkpointing the factorization of poly (of length len) by factorize, which adds its factors to fl
+//if a loaded checkpoint is of the same polynomial, its factors are added to fl and poly is set to its quotient
+//return the number of factors added
+int checkpoint_begin(checkpoint *ck, mpz_t *poly, int len, factor_list *fl){
+    int i,j,same;
+
+    if(ck==NULL)
+        return 0;
+    same=ck->resume&&ck->len==len;
+    for(i=0;same&&i<len;i++)
+        same=mpz_cmp(ck->start[i],poly[i])==0;
+    if(ck->resume&&!same)
+        fprintf(stderr,"Checkpoint %s is of another polynomial, starting from scratch.\n",ck->path);
+    ck->resume=0;
+    ck->fl=fl;
+    ck->first=fl->count;
+    ck->poly=poly;
+    if(!same){
+        checkpoint_poly_free(ck->start,ck->len);
+        ck->len=len;
+        ck->start=checkpoint_poly_alloc(len);
+        for(i=0;i<len;i++)
+            mpz_set(ck->start[i],poly[i]);
+        ck->deg_done=0;
+        ck->has_root=0;
+        return 0;
+    }
+    for(j=0;j<ck->found.count;j++)
+        factor_list_add(fl,factor_coefs(&ck->found,j),ck->found.degree[j],1);
+    for(i=0;i<len;i++)
+        mpz_set(poly[i],ck->rest[i]);
+    return ck->found.count;
+}
+
+//save if the last save is more than ck->interval seconds old
+void checkpoint_tick(checkpoint *ck){
+    if(ck!=NULL&&monotonic_seconds()-ck->last_save>=ck->interval)
+        checkpoint_save(ck);
+}
+
+//the quotient changed: forget its root
+void checkpoint_next(checkpoint *ck){
+    if(ck==NULL)
+        return;
+    ck->deg_done=0;
+    ck->has_root=0;
+}
+
+//set root to the saved root of the quotient. return 0 if there is none
+int checkpoint_get_root(checkpoint *ck, mpc_t root){
+    if(ck==NULL||!ck->has_root)
+        return 0;
+    mpc_set(root,ck->root,MPC_RNDNN);
+    return 1;
+}
+
+//record the root find_factor_cx is working on (unless it is the saved one already)
+void checkpoint_set_root(checkpoint *ck, const mpc_t root){
+    if(ck==NULL||ck->has_root)
+        return;
+    mpc_set_prec(ck->root,mpfr_get_prec(mpc_realref(root)));
+    mpc_set(ck->root,root,MPC_RNDNN);
+    ck->has_root=1;
+    ck->deg_done=0;
+}
+
+//record that LLL found no factor of degree deg on the root
+void checkpoint_degree(checkpoint *ck, int deg){
+    if(ck==NULL)
+        return;
+    ck->deg_done=deg;
+    checkpoint_tick(ck);
+}
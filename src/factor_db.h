@@ -0,0 +1,205 @@
+//---------about-----------------//
+
+//factor database: a table of small irreducible polynomials (cyclotomics and monic irreducibles of low degree and height)
+//generated by utils/make_factor_db.py and memory-mapped at startup. factorize() divides these out before
+//falling back to root finding + LLL, so most small factors never touch multiprecision floats.
+
+//---------notes-----------------//
+
+//file format (little-endian): "PFDB", u32 count, then for each entry: i32 degree, (degree+1) i32 coefficients
+//entries are sorted by degree and all monic.
+//each entry is first checked modulo a word-size prime; only entries that divide mod p are checked by polydivide()
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FACTOR_DB_PRIME 2147483647ULL //2^31-1, so that products of residues fit in 64 bits
+
+typedef struct {
+    int count; //number of entries
+    const unsigned char **entries; //entries[k] points at the degree field of entry k inside the map
+    void *map; //mapped file
+    size_t map_len;
+} factor_db;
+
+int32_t db_i32(const unsigned char *b);
+int factor_db_open(const char *path, factor_db *db);
+void factor_db_close(factor_db *db);
+void poly_mod_p(mpz_t *p, int len, uint64_t *out, uint64_t prime);
+int entry_mod_p(const unsigned char *entry, uint64_t *out, uint64_t prime);
+int divides_mod_p(const uint64_t *p, int deg_p, const uint64_t *d, int deg_d, uint64_t prime, uint64_t *work);
+int factor_db_divide(const factor_db *db, mpz_t *poly, int poly_len, factor_list *fl, int verbosity);
+
+//read little-endian 32-bit integer
+int32_t db_i32(const unsigned char *b){
+    return (int32_t)((uint32_t)b[0]|((uint32_t)b[1]<<8)|((uint32_t)b[2]<<16)|((uint32_t)b[3]<<24));
+}
+
+//map the database file at path and index its entries. return 0 on failure
+int factor_db_open(const char *path, factor_db *db){
+    int fd,k,deg;
+    struct stat st;
+    size_t offset;
+    const unsigned char *b;
+
+    db->count=0;
+    db->entries=NULL;
+    db->map=NULL;
+    db->map_len=0;
+
+    fd=open(path,O_RDONLY);
+    if(fd<0){
+        fprintf(stderr,"Could not open factor database %s\n",path);
+        return 0;
+    }
+    if(fstat(fd,&st)!=0||st.st_size<8){
+        fprintf(stderr,"Invalid factor database %s\n",path);
+        close(fd);
+        return 0;
+    }
+    db->map_len=st.st_size;
+    db->map=mmap(NULL,db->map_len,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(db->map==MAP_FAILED){
+        fprintf(stderr,"Could not map factor database %s\n",path);
+        db->map=NULL;
+        return 0;
+    }
+
+    b=db->map;
+    if(memcmp(b,"PFDB",4)!=0||db_i32(b+4)<0){
+        fprintf(stderr,"Invalid factor database %s\n",path);
+        factor_db_close(db);
+        return 0;
+    }
+    db->count=db_i32(b+4);
+    db->entries=malloc(MAX(db->count,1)*sizeof(unsigned char *));
+
+    //index entries, making sure none runs past the end of the file
+    offset=8;
+    for(k=0;k<db->count;k++){
+        if(offset+4>db->map_len)
+            break;
+        deg=db_i32(b+offset);
+        if(deg<1||offset+4*(size_t)(deg+2)>db->map_len||db_i32(b+offset+4*(deg+1))!=1)
+            break;
+        db->entries[k]=b+offset;
+        offset+=4*(deg+2);
+    }
+    if(k<db->count){
+        fprintf(stderr,"Invalid factor database %s (entry %d)\n",path,k);
+        factor_db_close(db);
+        return 0;
+    }
+    return 1;
+}
+
+void factor_db_close(factor_db *db){
+    if(db->map!=NULL)
+        munmap(db->map,db->map_len);
+    free(db->entries);
+    db->count=0;
+    db->entries=NULL;
+    db->map=NULL;
+}
+
+//reduce the coefficients of p mod prime
+void poly_mod_p(mpz_t *p, int len, uint64_t *out, uint64_t prime){
+    int i;
+    for(i=0;i<len;i++)
+        out[i]=mpz_fdiv_ui(p[i],prime);
+}
+
+//residues mod prime of the coefficients of entry (lowest first, deg+1 of them). return its degree
+int entry_mod_p(const unsigned char *entry, uint64_t *out, uint64_t prime){
+    int i,deg=db_i32(entry);
+    for(i=0;i<=deg;i++)
+        out[i]=(uint64_t)((db_i32(entry+4*(i+1))%(int64_t)prime+(int64_t)prime)%(int64_t)prime);
+    return deg;
+}
+
+//check if the monic polynomial d divides p mod prime (both given by their residues). work must hold deg_p+1 words.
+//return 1 if the remainder is zero mod prime (so d may divide p), 0 if it certainly doesn't
+int divides_mod_p(const uint64_t *p, int deg_p, const uint64_t *d, int deg_d, uint64_t prime, uint64_t *work){
+    int i,j;
+    uint64_t c;
+    if(deg_d>deg_p)
+        return 0;
+    for(i=0;i<=deg_p;i++)
+        work[i]=p[i];
+    //synthetic division from the top
+    for(i=deg_p;i>=deg_d;i--){
+        c=work[i];
+        if(c==0)
+            continue;
+        for(j=0;j<deg_d;j++)
+            work[i-deg_d+j]=(work[i-deg_d+j]+prime-(c*d[j])%prime)%prime; //work[i-deg_d+j] -= c*d[j]
+    }
+    for(i=0;i<deg_d;i++){
+        if(work[i]!=0)
+            return 0;
+    }
+    return 1;
+}
+
+//divide every database entry out of poly (square-free), adding each one found to fl.
+//poly is replaced by the remaining quotient. return the number of factors found
+int factor_db_divide(const factor_db *db, mpz_t *poly, int poly_len, factor_list *fl, int verbosity){
+    int i,k,deg_d,factor_counter=0;
+    int deg_p=degree(poly,poly_len);
+    uint64_t *p_mod=malloc(poly_len*sizeof(uint64_t));
+    uint64_t *work=malloc(poly_len*sizeof(uint64_t));
+    uint64_t *d_mod=malloc(poly_len*sizeof(uint64_t));
+    mpz_t *d=malloc(poly_len*sizeof(mpz_t));
+    mpz_t *q=malloc(poly_len*sizeof(mpz_t));
+    for(i=0;i<poly_len;i++){
+        mpz_init(d[i]);
+        mpz_init(q[i]);
+    }
+
+    poly_mod_p(poly,poly_len,p_mod,FACTOR_DB_PRIME);
+    for(k=0;k<db->count&&deg_p>0;k++){
+        deg_d=db_i32(db->entries[k]);
+        if(deg_d>deg_p)
+            break; //entries are sorted by degree
+        entry_mod_p(db->entries[k],d_mod,FACTOR_DB_PRIME);
+        if(!divides_mod_p(p_mod,deg_p,d_mod,deg_d,FACTOR_DB_PRIME,work))
+            continue;
+
+        //exact check (only over the current degree of poly)
+        for(i=0;i<=deg_p;i++)
+            mpz_set_si(d[i],i<=deg_d ? db_i32(db->entries[k]+4*(i+1)) : 0);
+        if(polydivide(poly,d,q,deg_p+1)!=0)
+            continue;
+
+        if(verbosity){
+            printf("Factor found in database:\n");
+            printf("--> ");
+            print_poly(deg_d+1,d,0);
+            printf(" <--\n");
+            printf("Quotient:\n");
+            print_poly(deg_p-deg_d+1,q,1);
+            printf("\n");
+        }
+        factor_list_add(fl,d,deg_d,1);
+        for(i=0;i<=deg_p;i++)
+            mpz_set(poly[i],q[i]);
+        factor_counter++;
+        deg_p=degree(poly,deg_p+1);
+        poly_mod_p(poly,deg_p+1,p_mod,FACTOR_DB_PRIME);
+    }
+
+    for(i=0;i<poly_len;i++){
+        mpz_clear(d[i]);
+        mpz_clear(q[i]);
+    }
+    free(d);
+    free(q);
+    free(p_mod);
+    free(work);
+    free(d_mod);
+    return factor_counter;
+}
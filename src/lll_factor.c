@@ -13,6 +13,7 @@
 #include <regex.h>
 #include "lll_gs.h" //includes gmp.h, mpfr.h, mpc.h, math.h
 #include "lll_functions.h" //function library for polynomials
+#include "tune_table.h" //precision/delta defaults per input class
 
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
@@ -35,7 +36,15 @@
 int lll_factor(int argc, char *argv[]);
 int read_csv(char *polystr,mpz_t *poly,int poly_len);
 int csv_len(char *str);
-int parameter_set(int argc, char *argv[],int *PRECISION, int *verbosity,int *timer,int *newline,double *delta,int *poly_len, int *stop_deg);
+int parameter_set(int argc, char *argv[],int *PRECISION, int *verbosity,int *timer,int *newline,double *delta,int *poly_len, int *stop_deg, int *bin_input, int *output_format, char **db_path, char **tune_path, int *profile, char **checkpoint_path, double *checkpoint_every, int *resume, factor_ctx *ctx);
+void cancel_handler(int sig);
+
+//output formats
+#define OUTPUT_TEXT 0
+#define OUTPUT_JSON 1
+#define OUTPUT_BIN 2
+
+static volatile sig_atomic_t cancel_requested=0; //set by SIGTERM/SIGINT/SIGXCPU, makes the factorization stop early
 
 
 int main(int argc,char *argv[]){
@@ -45,55 +54,98 @@ int main(int argc,char *argv[]){
 // factor polynomial from command line input (argv,argc)
 // return 0 if failed
 int lll_factor(int argc, char *argv[]) {
-    srand(1); //initialize random
-    int i,j;
-    int PRECISION=128; //bits of precision (for floats) - default 64
+    int i;
+    int PRECISION=0; //bits of precision (for floats) - 0 until set by -p, the tuning table or the default below
     int poly_len=0; //length of polynomial 
     int factor_counter; //number of factors 
     int verbosity=0; //verbosity bool
     int newline=0; //newline bool (for printing)
     int timer=0; //timer bool
     int stop_deg=0;// stop degree for LLL
-    double delta=0.5;//LLL parameter default
+    int bin_input=0; //polynomial given as a binary file bool
+    int output_format=OUTPUT_TEXT; //how to print the factors
+    FILE *bin_file=NULL; //binary input file
+    char *db_path=NULL; //factor database file
+    factor_db db; //memory-mapped factor database
+    factor_ctx ctx={NULL,0,{0,&cancel_requested,0,NULL,NULL,NULL,0,0,0},-1,NULL,NULL,RELATION_LLL,DEFAULT_SEED}; //state passed down to factorize_full
+    int profile=0; //print per-phase timings and LLL counters bool
+    run_stats stats={NULL,0,0,0,0,0}; //filled in by factorize_full if profiling
+    int complete; //0 if stopped early, in which case the last factor is the unfactored cofactor
+    double delta=0;//LLL parameter, 0 until set like PRECISION
+    char *tune_path=getenv(TUNE_TABLE_ENV); //precision/delta table, used for whichever of -p/-d isn't given
+    char *checkpoint_path=NULL; //file to save progress to
+    double checkpoint_every=CHECKPOINT_INTERVAL; //seconds between saves
+    int resume=0; //continue from checkpoint_path bool
+    checkpoint ck; //saved progress
     mpz_t *poly; //polynomial coefficients
-    mpz_t *allfactors; //factors list
-    int *multiplicities; //multiplicities of factors
+    factor_list allfactors; //factors and their multiplicities
 
     //read command line parameters
-    if(parameter_set(argc,argv,&PRECISION,&verbosity,&timer,&newline,&delta,&poly_len,&stop_deg)==0)
+    if(parameter_set(argc,argv,&PRECISION,&verbosity,&timer,&newline,&delta,&poly_len,&stop_deg,&bin_input,&output_format,&db_path,&tune_path,&profile,&checkpoint_path,&checkpoint_every,&resume,&ctx)==0)
         return 0;
+    if(bin_input){
+        bin_file=strcmp(argv[1],"-")==0 ? stdin : fopen(argv[1],"rb");
+        if(bin_file==NULL){
+            fprintf(stderr,"Could not open binary input file %s\n",argv[1]);
+            return 0;
+        }
+        poly_len=read_bin_len(bin_file);
+        if(poly_len<=0){
+            fprintf(stderr,"Invalid binary polynomial header.\n");
+            if(bin_file!=stdin)
+                fclose(bin_file);
+            return 0;
+        }
+    }
     if(stop_deg==0){stop_deg=poly_len;}
 
-    //print parameters
-    if(verbosity){printf("Working precision: %d\n",PRECISION);printf("LLL parameter: %lf\n",delta);}
-
-
-    //allocate input polynomial, its list of factors, and their multiplicities
+    //allocate input polynomial and its list of factors (sized for a few factors, it grows if needed)
     poly=malloc(poly_len*sizeof(mpz_t));
-    allfactors=malloc(poly_len*(poly_len-1)*sizeof(mpz_t));
-    multiplicities=malloc(poly_len*sizeof(int));
+    if(poly==NULL){
+        fprintf(stderr,"Out of memory for a polynomial of length %d.\n",poly_len);
+        if(bin_file!=NULL&&bin_file!=stdin)
+            fclose(bin_file);
+        return 0;
+    }
     for(i=0;i<poly_len;i++){
         mpz_init(poly[i]);
         mpz_set_ui(poly[i],0);
     }
-    for(i=0;i<poly_len*(poly_len-1);i++)
-        mpz_init(allfactors[i]);
+    factor_list_init(&allfactors,8,poly_len+8);
 
 
     //read polynomial and print it
-    if(!read_csv(argv[1],poly,poly_len)){
+    i=bin_input ? read_bin_poly(bin_file,poly,poly_len) : read_csv(argv[1],poly,poly_len);
+    if(bin_file!=NULL&&bin_file!=stdin)
+        fclose(bin_file);
+    if(!i){
         fprintf(stderr,"Input error. Expect <polynomial in csv> <-v for verbosity>\n");
-        for(i=0;i<poly_len;i++){
+        for(i=0;i<poly_len;i++)
             mpz_clear(poly[i]);
-            for(j=0;j<poly_len-1;j++)
-                mpz_clear(allfactors[j*poly_len+i]);
-        }
-        free(allfactors);
+        factor_list_clear(&allfactors);
         free(poly);
-        free(multiplicities);
 
         return 0;
     }
+
+    //choose precision and delta: command line, then tuning table, then defaults
+    if((PRECISION==0||delta==0)&&tune_path!=NULL&&tune_path[0]!='\0'){
+        int tuned_precision=PRECISION;
+        double tuned_delta=delta;
+        if(tune_lookup(tune_path,degree(poly,poly_len),height_bits(poly,poly_len),&tuned_precision,&tuned_delta)){
+            if(PRECISION==0)
+                PRECISION=tuned_precision;
+            if(delta==0)
+                delta=tuned_delta;
+        }
+    }
+    if(PRECISION==0)
+        PRECISION=128;
+    if(delta==0)
+        delta=0.5;
+
+    //print parameters
+    if(verbosity){printf("Working precision: %d\n",PRECISION);printf("LLL parameter: %lf\n",delta);}
     if(verbosity){
         printf("Polynomial input: ");
         print_poly(poly_len,poly,1);
@@ -105,11 +157,59 @@ int lll_factor(int argc, char *argv[]) {
         printf("================================================================================================\n\n");
     }
 
+    //stop cleanly (printing what was found so far) when asked to terminate or out of cpu time
+    signal(SIGTERM,cancel_handler);
+    signal(SIGINT,cancel_handler);
+    signal(SIGXCPU,cancel_handler);
+
+    //map factor database
+    if(db_path!=NULL&&!factor_db_open(db_path,&db))
+        db_path=NULL; //carry on without it
+    if(db_path!=NULL)
+        ctx.db=&db;
+    if(profile)
+        ctx.stats=&stats;
+
+    //set up checkpoints, picking up the last one if resuming (no checkpoint yet: start from scratch)
+    if(checkpoint_path!=NULL){
+        checkpoint_init(&ck,checkpoint_path,checkpoint_every,PRECISION,delta);
+        if(resume&&checkpoint_load(&ck)==0){
+            checkpoint_clear(&ck);
+            if(db_path!=NULL)
+                factor_db_close(&db);
+            for(i=0;i<poly_len;i++)
+                mpz_clear(poly[i]);
+            factor_list_clear(&allfactors);
+            free(poly);
+            return 0;
+        }
+        ctx.ck=&ck;
+    }
+
     //factor it
     clock_t start=clock(),diff;
-    factor_counter=factorize_full(poly,poly_len,PRECISION,allfactors,multiplicities,verbosity,delta,stop_deg);	
+    double wall_start=monotonic_seconds();
+    factor_counter=factorize_full(poly,poly_len,PRECISION,&allfactors,verbosity,delta,stop_deg,&ctx);	
     diff=clock()-start;
     int msec_time=diff*1000/CLOCKS_PER_SEC;
+    if(db_path!=NULL)
+        factor_db_close(&db);
+    if(checkpoint_path!=NULL){
+        checkpoint_clear(&ck);
+        if(factor_counter>0&&ctx.cofactor<0)
+            remove(checkpoint_path); //done, nothing to resume
+    }
+    if(profile){
+        print_stats_json(stderr,&stats,PRECISION,delta,1e3*(monotonic_seconds()-wall_start),1e3*(double)diff/CLOCKS_PER_SEC);
+        run_stats_clear(&stats);
+    }
+
+    //move the unfactored cofactor (if any) to the end of the list
+    complete=ctx.cofactor<0;
+    if(!complete&&factor_counter>0){
+        factor_list_swap(&allfactors,ctx.cofactor,factor_counter-1);
+        fprintf(stderr,"Stopped early, factorization is not complete.\n");
+    }
 
     if(verbosity){
         printf("================================================================================================\n");
@@ -119,42 +219,51 @@ int lll_factor(int argc, char *argv[]) {
 
     //print factors
     if(factor_counter>0){
-        if(verbosity){printf("Factorization:\n");}
-        print_factors(allfactors,multiplicities,factor_counter,poly_len,0,newline);
-        printf("\n");
+        if(output_format==OUTPUT_JSON)
+            print_factors_json(&allfactors,complete,timer ? msec_time : -1);
+        else if(output_format==OUTPUT_BIN)
+            print_factors_bin(&allfactors,complete);
+        else{
+            if(verbosity){printf("Factorization:\n");}
+            print_factors(&allfactors,0,factor_counter-!complete,0,newline);
+            printf("\n");
+            if(!complete){
+                printf("Unfactored: ");
+                print_factors(&allfactors,factor_counter-1,1,0,0);
+                printf("\n");
+            }
+        }
     }
     else{
         fprintf(stderr,"Factorization failed\n");
-        for(i=0;i<poly_len;i++){
+        for(i=0;i<poly_len;i++)
             mpz_clear(poly[i]);
-            for(j=0;j<poly_len-1;j++)
-                mpz_clear(allfactors[j*poly_len+i]);
-        }
-        free(allfactors);
+        factor_list_clear(&allfactors);
         free(poly);
-        free(multiplicities);
 
         return 0;
     }
 
-    //print time taken
-    if(timer)
+    //print time taken (json output carries its own time field)
+    if(timer&&output_format==OUTPUT_TEXT)
         printf("Time: %dms\n",msec_time);
 
 
     //clear variables
-    for(i=0;i<poly_len;i++){
+    for(i=0;i<poly_len;i++)
         mpz_clear(poly[i]);
-        for(j=0;j<poly_len-1;j++)
-            mpz_clear(allfactors[j*poly_len+i]);
-    }
-    free(allfactors);
+    factor_list_clear(&allfactors);
     free(poly);
-    free(multiplicities);
     return 1;
 }
 
 
+//ask the factorization to stop at the next check (see lll_control)
+void cancel_handler(int sig){
+    (void)sig;
+    cancel_requested=1;
+}
+
 //read csv to polynomial
 //return zero if failed, nonzero value if succeeded. 
 int read_csv(char *polystr,mpz_t *poly,int poly_len){
@@ -191,12 +300,12 @@ int csv_len(char *str){
 }
 
 //parse command line input and set the relevant parameters
-int parameter_set(int argc, char *argv[],int *PRECISION, int *verbosity,int *timer,int *newline,double *delta,int *poly_len, int* stop_deg){
+int parameter_set(int argc, char *argv[],int *PRECISION, int *verbosity,int *timer,int *newline,double *delta,int *poly_len, int* stop_deg, int *bin_input, int *output_format, char **db_path, char **tune_path, int *profile, char **checkpoint_path, double *checkpoint_every, int *resume, factor_ctx *ctx){
     int i;
 
     //no arguments passed
     if(argc==1){
-        printf("Input is a monic polynomial in Z[x], written without spaces (e.g. x^2-x+2)\nFormat: <polynomial> <OPTS>\n        OPTS: -v: verbosity\n              -t: timer\n              -p: precision in bits (e.g. -p 150). Default is 64, minimum of 32.\n              -d: LLL parameter (0.25<d<1). Default is 0.5.\n              -newline: print each factor on a new line.\n              -stop: Stop degree for LLL algorithm. Default is infinity.\n");
+        printf("Input is a polynomial in Z[x], written without spaces (e.g. x^2-x+2)\nFormat: <polynomial> <OPTS>\n        OPTS: -v: verbosity\n              -t: timer\n              -p: precision in bits (e.g. -p 150). Default is 128 (or from -tune), minimum of 32.\n              -d: LLL parameter (0.25<d<1). Default is 0.5 (or from -tune).\n              -newline: print each factor on a new line.\n              -stop: Stop degree for LLL algorithm. Default is infinity.\n              -bin: polynomial argument is a binary file (- for stdin) instead of csv.\n              -json: print factors as json (disables -v).\n              -obin: write factors to stdout in binary format (disables -v, -t).\n              -db: factor database file (see utils/make_factor_db.py) to divide out before using LLL.\n              -progress: print progress events (one json object per line) on stderr.\n              -timeout: stop after this many milliseconds and print the factors found so far and the unfactored rest.\n              -max_iterations: same as -timeout, but stop after this many LLL iterations (stops at the same point on every run).\n              -stats: print per-phase timings and LLL counters (one json object) on stderr.\n              -tune: precision/delta table (see utils/tune.py) used when -p or -d are not given. Default: $POLY_FACTOR_TUNE_TABLE.\n              -checkpoint: file to save progress to (every minute, and when stopping early), removed once the factorization is complete.\n              -checkpoint_every: seconds between checkpoint saves. Default is 60.\n              -resume: continue from the -checkpoint file (if there is one).\n              -alg: lll or pslq, how the minimal polynomial of a root is found. Default is lll.\n              -seed: seed of the random starting points of root finding (runs with the same seed give the same results). Default is 1.\n              -block: segment LLL: lattices of at least twice this many vectors are reduced in segments of this size (on separate threads) before the whole basis.\n");
         return 0;
     }
     //get putative polynomial length and set options
@@ -213,6 +322,40 @@ int parameter_set(int argc, char *argv[],int *PRECISION, int *verbosity,int *tim
             }
             else if(strcmp(argv[i],"-newline")==0)
                 *newline=1;
+            else if(strcmp(argv[i],"-bin")==0)
+                *bin_input=1;
+            else if(strcmp(argv[i],"-json")==0)
+                *output_format=OUTPUT_JSON;
+            else if(strcmp(argv[i],"-obin")==0)
+                *output_format=OUTPUT_BIN;
+            else if(strcmp(argv[i],"-progress")==0)
+                ctx->progress=1;
+            else if(strcmp(argv[i],"-stats")==0)
+                *profile=1;
+            else if(strcmp(argv[i],"-timeout")==0){
+                i++;
+                if(i==argc||strtol(argv[i],NULL,10)<=0){
+                    fprintf(stderr,"Timeout indicated not a positive integer.\n");
+                    return 0;
+                }
+                lll_set_timeout(&ctx->ctl,strtol(argv[i],NULL,10));
+            }
+            else if(strcmp(argv[i],"-block")==0){
+                i++;
+                if(i==argc||strtol(argv[i],NULL,10)<2){
+                    fprintf(stderr,"Block size indicated not an integer of at least 2.\n");
+                    return 0;
+                }
+                lll_block_size=strtol(argv[i],NULL,10);
+            }
+            else if(strcmp(argv[i],"-max_iterations")==0){
+                i++;
+                if(i==argc||strtol(argv[i],NULL,10)<=0){
+                    fprintf(stderr,"Maximum number of iterations indicated not a positive integer.\n");
+                    return 0;
+                }
+                ctx->ctl.max_iterations=strtol(argv[i],NULL,10);
+            }
             else if(strcmp(argv[i],"-p")==0){
                 i++;
                 if(i==argc){
@@ -243,6 +386,56 @@ int parameter_set(int argc, char *argv[],int *PRECISION, int *verbosity,int *tim
                 }
 
             }
+            else if(strcmp(argv[i],"-db")==0){
+                i++;
+                if(i==argc){
+                    fprintf(stderr,"Factor database file not given.\n");
+                    return 0;
+                }
+                *db_path=argv[i];
+            }
+            else if(strcmp(argv[i],"-tune")==0){
+                i++;
+                if(i==argc){
+                    fprintf(stderr,"Tuning table file not given.\n");
+                    return 0;
+                }
+                *tune_path=argv[i];
+            }
+            else if(strcmp(argv[i],"-checkpoint")==0){
+                i++;
+                if(i==argc){
+                    fprintf(stderr,"Checkpoint file not given.\n");
+                    return 0;
+                }
+                *checkpoint_path=argv[i];
+            }
+            else if(strcmp(argv[i],"-checkpoint_every")==0){
+                i++;
+                if(i==argc||strtod(argv[i],NULL)<0){
+                    fprintf(stderr,"Checkpoint interval indicated not a nonnegative number.\n");
+                    return 0;
+                }
+                *checkpoint_every=strtod(argv[i],NULL);
+            }
+            else if(strcmp(argv[i],"-resume")==0)
+                *resume=1;
+            else if(strcmp(argv[i],"-alg")==0){
+                i++;
+                if(i==argc||relation_alg(argv[i])<0){
+                    fprintf(stderr,"Algorithm indicated not lll or pslq.\n");
+                    return 0;
+                }
+                ctx->relation=relation_alg(argv[i]);
+            }
+            else if(strcmp(argv[i],"-seed")==0){
+                i++;
+                if(i==argc||!isdigit((unsigned char)argv[i][0])){
+                    fprintf(stderr,"Seed indicated not a nonnegative integer.\n");
+                    return 0;
+                }
+                ctx->seed=strtoull(argv[i],NULL,10);
+            }
             else if(strcmp(argv[i],"-stop")==0){
                 i++;
                 if(i==argc){
@@ -256,6 +449,13 @@ int parameter_set(int argc, char *argv[],int *PRECISION, int *verbosity,int *tim
                 return 0;
             }
         }
+        if(*resume&&*checkpoint_path==NULL){
+            fprintf(stderr,"-resume needs a -checkpoint file.\n");
+            return 0;
+        }
+        //structured output is meant to be read by another program, so keep stdout clean
+        if(*output_format!=OUTPUT_TEXT)
+            *verbosity=0;
     }
     return 1;
 }
@@ -0,0 +1,1023 @@
+//---------about-----------------//
+
+//fixed precision backends for LLL: the gram schmidt data (obasis, mu, norms) is kept in floating point
+//expansions of FP_N doubles (unevaluated sums x[0]+x[1]+..., each component below the last bit of the previous one)
+//instead of mpf_t. FP_N=2 is double-double (106 bits), FP_N=4 quad-double (212 bits).
+//this file is a template: define FP (prefix of the generated names) and FP_N, then include it, e.g.
+//    #define FP dd
+//    #define FP_N 2
+//    #include "lll_fp.h"
+//generates the type dd_real and dd_add(), dd_mul(), ..., dd_LLL(). LLL_ctl picks a backend from PRECISION.
+//define FP_FMA to 1 as well when the instantiation is compiled for AVX2+FMA (see lll_gs.h).
+
+//---------notes-----------------//
+
+//the algorithms are the usual ones for expansions (see the QD library of Hida, Li and Bailey): every sum or product
+//is formed exactly as a list of doubles with two_sum/two_prod, then renormalized back to FP_N components.
+//two_prod uses fma in the FP_FMA instantiations (or when the compiler says it is fast, FP_FAST_FMA), Dekker's
+//splitting otherwise. in the FP_FMA instantiations, dot products also run four entries at a time.
+//the exponent range is that of a double, so LLL_ctl only uses these backends when the basis entries are
+//small enough that their squared norms fit (see lll_fp_fits).
+
+//-------- shared helpers (once) --------//
+#ifndef LLL_FP_COMMON
+#define LLL_FP_COMMON
+
+#if defined(__GNUC__)&&defined(__x86_64__)
+#define LLL_FP_X86 1
+#include <immintrin.h>
+#else
+#define LLL_FP_X86 0
+#endif
+
+#include <pthread.h>
+#include <unistd.h>
+#include <limits.h>
+
+#define LLL_FP_MAX_BITS 480 //largest basis entry (in bits) the double based backends accept
+#define SEGMENT_MAX_ROUNDS 64 //rounds of segment reductions before LLL_segment leaves the rest to the full pass
+#define SEGMENT_MAX_ITERATIONS 100000 //cap on the LLL iterations of one segment reduction (floating point could cycle)
+#define FP_SPLITTER 134217729.0 //2^27+1, for Dekker's splitting
+
+int lll_fp_fits(int len, mpz_t *basis);
+int lll_fp_simd(void);
+int lll_fp_threads(void);
+
+//s=fl(a+b), *err=a+b-s exactly
+static inline double fp_two_sum(double a, double b, double *err){
+    double s=a+b;
+    double bb=s-a;
+    *err=(a-(s-bb))+(b-bb);
+    return s;
+}
+
+//same, assuming |a|>=|b|
+static inline double fp_quick_two_sum(double a, double b, double *err){
+    double s=a+b;
+    *err=b-(s-a);
+    return s;
+}
+
+//(a,b,c) -> (a+b+c rounded, then the errors)
+static inline void fp_three_sum(double *a, double *b, double *c){
+    double t1,t2,t3;
+    t1=fp_two_sum(*a,*b,&t2);
+    *a=fp_two_sum(*c,t1,&t3);
+    *b=fp_two_sum(t2,t3,c);
+}
+
+//same, but only two outputs
+static inline void fp_three_sum2(double *a, double *b, double *c){
+    double t1,t2,t3;
+    t1=fp_two_sum(*a,*b,&t2);
+    *a=fp_two_sum(*c,t1,&t3);
+    *b=t2+t3;
+}
+
+//return 1 if every entry of basis has at most LLL_FP_MAX_BITS bits
+int lll_fp_fits(int len, mpz_t *basis){
+    int i;
+    for(i=0;i<len;i++){
+        if(mpz_sizeinbase(basis[i],2)>LLL_FP_MAX_BITS)
+            return 0;
+    }
+    return 1;
+}
+
+//1 if the cpu has AVX2 and FMA (checked once)
+int lll_fp_simd(void){
+    static int simd=-1;
+#if LLL_FP_X86
+    if(simd<0)
+        simd=__builtin_cpu_supports("avx2")&&__builtin_cpu_supports("fma");
+#else
+    simd=0;
+#endif
+    return simd;
+}
+
+//number of threads for the segment reductions (online cpus, checked once)
+int lll_fp_threads(void){
+    static int threads=0;
+    if(threads<1)
+        threads=MAX(1,(int)sysconf(_SC_NPROCESSORS_ONLN));
+    return threads;
+}
+
+#endif
+
+//-------- template (once per FP) --------//
+#define FP_CAT2(a,b) a##_##b
+#define FP_CAT(a,b) FP_CAT2(a,b)
+#define FP_FN(name) FP_CAT(FP,name)
+#define FP_T FP_FN(real)
+
+typedef struct {
+    double x[FP_N];
+} FP_T;
+
+//p=fl(a*b), *err=a*b-p exactly
+static inline double FP_FN(two_prod)(double a, double b, double *err){
+    double p=a*b;
+#if defined(FP_FAST_FMA)||FP_FMA
+    *err=fma(a,b,-p);
+#else
+    double t,a_hi,a_lo,b_hi,b_lo;
+    t=FP_SPLITTER*a; a_hi=t-(t-a); a_lo=a-a_hi;
+    t=FP_SPLITTER*b; b_hi=t-(t-b); b_lo=b-b_hi;
+    *err=((a_hi*b_hi-p)+a_hi*b_lo+a_lo*b_hi)+a_lo*b_lo;
+#endif
+    return p;
+}
+
+void FP_FN(renorm)(double *t, int m, FP_T *r);
+#if FP_N==4
+void FP_FN(renorm5)(double *c, FP_T *r);
+#endif
+void FP_FN(set_d)(FP_T *r, double d);
+void FP_FN(set_z)(FP_T *r, mpz_t z, mpz_t rest, mpz_t tmp);
+void FP_FN(get_z)(mpz_t rop, const FP_T *a, mpz_t tmp);
+int FP_FN(sgn)(const FP_T *a);
+void FP_FN(neg)(FP_T *r, const FP_T *a);
+void FP_FN(add)(FP_T *r, const FP_T *a, const FP_T *b);
+void FP_FN(sub)(FP_T *r, const FP_T *a, const FP_T *b);
+void FP_FN(mul)(FP_T *r, const FP_T *a, const FP_T *b);
+void FP_FN(div)(FP_T *r, const FP_T *a, const FP_T *b);
+int FP_FN(cmp)(const FP_T *a, const FP_T *b);
+void FP_FN(dot)(FP_T *r, int len, const FP_T *x, const FP_T *y);
+#if FP_FMA
+int FP_FN(dot_avx2)(FP_T *r, int len, const FP_T *x, const FP_T *y);
+#endif
+void FP_FN(gram_schmidt)(int start, int dim, int nvec, FP_T *fbasis, FP_T *obasis, FP_T *onorm, FP_T *oinv);
+int FP_FN(LLL)(int dim, int nvec, mpz_t *basis, double delta, lll_control *ctl, lll_stats *stats);
+int FP_FN(LLL_rows)(int dim, int nvec, mpz_t *basis, FP_T *fbasis, int prefix, mpz_t *pbasis, FP_T *pobasis, FP_T *poinv, double delta, long max_iterations, lll_control *ctl, lll_stats *stats);
+int FP_FN(project)(int dim, int k, mpz_t *basis, FP_T *fbasis, FP_T *proj, int prefix, mpz_t *pbasis, FP_T *pobasis, FP_T *poinv, lll_stats *stats);
+int FP_FN(size_reduce)(int dim, int nvec, mpz_t *basis, FP_T *fbasis, FP_T *obasis, FP_T *onorm, FP_T *oinv, lll_stats *stats);
+void *FP_FN(segment_thread)(void *arg);
+int FP_FN(LLL_segment)(int dim, int nvec, mpz_t *basis, double delta, int block, lll_control *ctl, lll_stats *stats);
+
+//segment reductions of one thread in LLL_segment: segments first, first+step, ... of seg
+typedef struct {
+    int dim;
+    mpz_t *basis; //the whole basis, only read (the prefix of every segment)
+    FP_T *fbasis,*obasis,*oinv; //and its expansions and g.s. data
+    mpz_t *wbasis; //working copies of the segment rows (same indices as basis)
+    FP_T *wfbasis;
+    int *seg; //segment k is rows seg[2k] to seg[2k+1]-1
+    int count,first,step;
+    int projected; //0: reduce each segment on its own, without the rows before it
+    double delta;
+    lll_stats stats; //counts of this thread
+} FP_FN(segment_job);
+
+//renormalize the m terms in t (exact, roughly decreasing in magnitude, possibly overlapping) to FP_N components.
+//t is overwritten
+void FP_FN(renorm)(double *t, int m, FP_T *r){
+#if FP_N==4
+    if(m==5){
+        FP_FN(renorm5)(t,r);
+        return;
+    }
+#endif
+    double s,e;
+    int i,k;
+
+    //bottom up: s is the rounded sum, t[1..] the (exact) rounding errors
+    s=t[m-1];
+    for(i=m-2;i>=0;i--)
+        s=fp_two_sum(t[i],s,&t[i+1]);
+    t[0]=s;
+
+    //top down: keep the leading FP_N nonzero components
+    k=0;
+    s=t[0];
+    for(i=1;i<m&&k<FP_N-1;i++){
+        s=fp_two_sum(s,t[i],&e);
+        if(e!=0){
+            r->x[k++]=s;
+            s=e;
+        }
+    }
+    for(;i<m;i++)
+        s+=t[i]; //below the last component
+    r->x[k++]=s;
+    while(k<FP_N)
+        r->x[k++]=0;
+}
+
+#if FP_N==4
+//renorm of the 5 terms from quad-double add and mul, which come out ordered (renorm of the QD library)
+void FP_FN(renorm5)(double *c, FP_T *r){
+    double s0,s1,s2=0,s3=0;
+    s0=fp_quick_two_sum(c[3],c[4],&c[4]);
+    s0=fp_quick_two_sum(c[2],s0,&c[3]);
+    s0=fp_quick_two_sum(c[1],s0,&c[2]);
+    c[0]=fp_quick_two_sum(c[0],s0,&c[1]);
+
+    s0=c[0];
+    s1=c[1];
+    if(s1!=0){
+        s1=fp_quick_two_sum(s1,c[2],&s2);
+        if(s2!=0){
+            s2=fp_quick_two_sum(s2,c[3],&s3);
+            if(s3!=0)
+                s3+=c[4];
+            else
+                s2=fp_quick_two_sum(s2,c[4],&s3);
+        }
+        else{
+            s1=fp_quick_two_sum(s1,c[3],&s2);
+            if(s2!=0)
+                s2=fp_quick_two_sum(s2,c[4],&s3);
+            else
+                s1=fp_quick_two_sum(s1,c[4],&s2);
+        }
+    }
+    else{
+        s0=fp_quick_two_sum(s0,c[2],&s1);
+        if(s1!=0){
+            s1=fp_quick_two_sum(s1,c[3],&s2);
+            if(s2!=0)
+                s2=fp_quick_two_sum(s2,c[4],&s3);
+            else
+                s1=fp_quick_two_sum(s1,c[4],&s2);
+        }
+        else{
+            s0=fp_quick_two_sum(s0,c[3],&s1);
+            if(s1!=0)
+                s1=fp_quick_two_sum(s1,c[4],&s2);
+            else
+                s0=fp_quick_two_sum(s0,c[4],&s1);
+        }
+    }
+    r->x[0]=s0;
+    r->x[1]=s1;
+    r->x[2]=s2;
+    r->x[3]=s3;
+}
+#endif
+
+void FP_FN(set_d)(FP_T *r, double d){
+    int i;
+    r->x[0]=d;
+    for(i=1;i<FP_N;i++)
+        r->x[i]=0;
+}
+
+//r=z, rounded to FP_N components. rest and tmp are scratch space
+void FP_FN(set_z)(FP_T *r, mpz_t z, mpz_t rest, mpz_t tmp){
+    double t[FP_N+1];
+    int i;
+    mpz_set(rest,z);
+    for(i=0;i<=FP_N;i++){
+        t[i]=mpz_get_d(rest); //truncated, the next term picks up what is left
+        mpz_set_d(tmp,t[i]);
+        mpz_sub(rest,rest,tmp);
+    }
+    FP_FN(renorm)(t,FP_N+1,r);
+}
+
+//rop=nearest integer to a. tmp is scratch space
+void FP_FN(get_z)(mpz_t rop, const FP_T *a, mpz_t tmp){
+    double r;
+    int i;
+    mpz_set_ui(rop,0);
+    for(i=0;i<FP_N;i++){
+        r=nearbyint(a->x[i]);
+        if(r!=a->x[i]){
+            //first component with a fractional part. on a tie, the rest decides
+            if(fabs(r-a->x[i])==0.5&&i+1<FP_N&&a->x[i+1]!=0&&(a->x[i+1]>0)!=(r>a->x[i]))
+                r+=r>a->x[i] ? -1 : 1;
+            mpz_set_d(tmp,r);
+            mpz_add(rop,rop,tmp);
+            break;
+        }
+        mpz_set_d(tmp,r);
+        mpz_add(rop,rop,tmp);
+    }
+}
+
+int FP_FN(sgn)(const FP_T *a){
+    return (a->x[0]>0)-(a->x[0]<0);
+}
+
+void FP_FN(neg)(FP_T *r, const FP_T *a){
+    int i;
+    for(i=0;i<FP_N;i++)
+        r->x[i]=-a->x[i];
+}
+
+void FP_FN(add)(FP_T *r, const FP_T *a, const FP_T *b){
+#if FP_N==2
+    //double-double: the usual accurate sum of the high and low parts
+    double s1,s2,t1,t2;
+    s1=fp_two_sum(a->x[0],b->x[0],&s2);
+    t1=fp_two_sum(a->x[1],b->x[1],&t2);
+    s2+=t1;
+    s1=fp_quick_two_sum(s1,s2,&s2);
+    s2+=t2;
+    r->x[0]=fp_quick_two_sum(s1,s2,&r->x[1]);
+#elif FP_N==4
+    //quad-double: componentwise sums, their errors carried down (sloppy_add of the QD library)
+    double s[5],t0,t1,t2,t3;
+    s[0]=fp_two_sum(a->x[0],b->x[0],&t0);
+    s[1]=fp_two_sum(a->x[1],b->x[1],&t1);
+    s[2]=fp_two_sum(a->x[2],b->x[2],&t2);
+    s[3]=fp_two_sum(a->x[3],b->x[3],&t3);
+    s[1]=fp_two_sum(s[1],t0,&t0);
+    fp_three_sum(&s[2],&t0,&t1);
+    fp_three_sum2(&s[3],&t0,&t2);
+    s[4]=t0+t1+t3;
+    FP_FN(renorm)(s,5,r);
+#else
+    double t[2*FP_N];
+    int i=0,j=0,k=0;
+    //merge the components by decreasing magnitude
+    while(i<FP_N&&j<FP_N)
+        t[k++]=fabs(a->x[i])>=fabs(b->x[j]) ? a->x[i++] : b->x[j++];
+    while(i<FP_N)
+        t[k++]=a->x[i++];
+    while(j<FP_N)
+        t[k++]=b->x[j++];
+    FP_FN(renorm)(t,2*FP_N,r);
+#endif
+}
+
+void FP_FN(sub)(FP_T *r, const FP_T *a, const FP_T *b){
+    FP_T nb;
+    FP_FN(neg)(&nb,b);
+    FP_FN(add)(r,a,&nb);
+}
+
+void FP_FN(mul)(FP_T *r, const FP_T *a, const FP_T *b){
+#if FP_N==2
+    double p,e;
+    p=FP_FN(two_prod)(a->x[0],b->x[0],&e);
+    e+=a->x[0]*b->x[1]+a->x[1]*b->x[0];
+    r->x[0]=fp_quick_two_sum(p,e,&r->x[1]);
+#elif FP_N==4
+    //quad-double: products of level 0-2 exactly, level 3 approximately (sloppy_mul of the QD library)
+    double p0,p1,p2,p3,p4,p5,q0,q1,q2,q3,q4,q5,s0,s1,s2,t0,t1;
+    double c[5];
+    p0=FP_FN(two_prod)(a->x[0],b->x[0],&q0);
+    p1=FP_FN(two_prod)(a->x[0],b->x[1],&q1);
+    p2=FP_FN(two_prod)(a->x[1],b->x[0],&q2);
+    p3=FP_FN(two_prod)(a->x[0],b->x[2],&q3);
+    p4=FP_FN(two_prod)(a->x[1],b->x[1],&q4);
+    p5=FP_FN(two_prod)(a->x[2],b->x[0],&q5);
+    fp_three_sum(&p1,&p2,&q0);
+    //(s0,s1,s2)=(p2,q1,q2)+(p3,p4,p5)
+    fp_three_sum(&p2,&q1,&q2);
+    fp_three_sum(&p3,&p4,&p5);
+    s0=fp_two_sum(p2,p3,&t0);
+    s1=fp_two_sum(q1,p4,&t1);
+    s2=q2+p5;
+    s1=fp_two_sum(s1,t0,&t0);
+    s2+=t0+t1;
+    s1+=a->x[0]*b->x[3]+a->x[1]*b->x[2]+a->x[2]*b->x[1]+a->x[3]*b->x[0]+q0+q3+q4+q5;
+    c[0]=p0; c[1]=p1; c[2]=s0; c[3]=s1; c[4]=s2;
+    FP_FN(renorm)(c,5,r);
+#else
+    double t[FP_N*(FP_N+1)];
+    double err[FP_N][FP_N];
+    int i,level,m=0;
+    //products a[i]*b[j] level by level (i+j), followed by the errors of the level before. the products of
+    //level FP_N-1 are only needed approximately, higher levels not at all
+    for(level=0;level<FP_N;level++){
+        for(i=0;i<=level;i++){
+            if(level<FP_N-1)
+                t[m++]=FP_FN(two_prod)(a->x[i],b->x[level-i],&err[i][level-i]);
+            else
+                t[m++]=a->x[i]*b->x[level-i];
+        }
+        for(i=0;i<level;i++)
+            t[m++]=err[i][level-1-i];
+    }
+    FP_FN(renorm)(t,m,r);
+#endif
+}
+
+//long division: FP_N+1 quotient digits, each from the leading component of the remainder
+void FP_FN(div)(FP_T *r, const FP_T *a, const FP_T *b){
+    double q[FP_N+1];
+    FP_T rem,qb,qd;
+    int i;
+    rem=*a;
+    for(i=0;i<=FP_N;i++){
+        q[i]=rem.x[0]/b->x[0];
+        if(i==FP_N)
+            break;
+        FP_FN(set_d)(&qd,q[i]);
+        FP_FN(mul)(&qb,&qd,b);
+        FP_FN(sub)(&rem,&rem,&qb);
+    }
+    FP_FN(renorm)(q,FP_N+1,r);
+}
+
+int FP_FN(cmp)(const FP_T *a, const FP_T *b){
+    FP_T d;
+    FP_FN(sub)(&d,a,b);
+    return FP_FN(sgn)(&d);
+}
+
+//r=x.y
+void FP_FN(dot)(FP_T *r, int len, const FP_T *x, const FP_T *y){
+    FP_T p;
+    int i=0;
+    FP_FN(set_d)(r,0);
+#if FP_FMA
+    i=FP_FN(dot_avx2)(r,len,x,y);
+#endif
+    for(;i<len;i++){
+        FP_FN(mul)(&p,&x[i],&y[i]);
+        FP_FN(add)(r,r,&p);
+    }
+}
+
+#if FP_N==2&&FP_FMA
+//double-double dot product of the first len-len%4 entries, four at a time (one per lane). r must be zero.
+//returns the number of entries done
+int FP_FN(dot_avx2)(FP_T *r, int len, const FP_T *x, const FP_T *y){
+    __m256d x0,x1,y0,y1,xh,xl,yh,yl,ph,pl,sh,sl,s1,s2,t1,t2,bb;
+    double lane_h[4],lane_l[4];
+    FP_T lane;
+    int i;
+    if(len<4)
+        return 0;
+    sh=_mm256_setzero_pd();
+    sl=_mm256_setzero_pd();
+    for(i=0;i+4<=len;i+=4){
+        //deinterleave (hi,lo) pairs. the lanes come out in the order 0 2 1 3, the same for x and y
+        x0=_mm256_loadu_pd(x[i].x);
+        x1=_mm256_loadu_pd(x[i+2].x);
+        y0=_mm256_loadu_pd(y[i].x);
+        y1=_mm256_loadu_pd(y[i+2].x);
+        xh=_mm256_unpacklo_pd(x0,x1);
+        xl=_mm256_unpackhi_pd(x0,x1);
+        yh=_mm256_unpacklo_pd(y0,y1);
+        yl=_mm256_unpackhi_pd(y0,y1);
+
+        //p=x*y
+        ph=_mm256_mul_pd(xh,yh);
+        pl=_mm256_fmsub_pd(xh,yh,ph);
+        pl=_mm256_fmadd_pd(xh,yl,pl);
+        pl=_mm256_fmadd_pd(xl,yh,pl);
+        s1=_mm256_add_pd(ph,pl);
+        pl=_mm256_sub_pd(pl,_mm256_sub_pd(s1,ph));
+        ph=s1;
+
+        //s=s+p
+        s1=_mm256_add_pd(sh,ph);
+        bb=_mm256_sub_pd(s1,sh);
+        s2=_mm256_add_pd(_mm256_sub_pd(sh,_mm256_sub_pd(s1,bb)),_mm256_sub_pd(ph,bb));
+        t1=_mm256_add_pd(sl,pl);
+        bb=_mm256_sub_pd(t1,sl);
+        t2=_mm256_add_pd(_mm256_sub_pd(sl,_mm256_sub_pd(t1,bb)),_mm256_sub_pd(pl,bb));
+        s2=_mm256_add_pd(s2,t1);
+        sh=_mm256_add_pd(s1,s2);
+        s2=_mm256_sub_pd(s2,_mm256_sub_pd(sh,s1));
+        s2=_mm256_add_pd(s2,t2);
+        s1=sh;
+        sh=_mm256_add_pd(s1,s2);
+        sl=_mm256_sub_pd(s2,_mm256_sub_pd(sh,s1));
+    }
+    _mm256_storeu_pd(lane_h,sh);
+    _mm256_storeu_pd(lane_l,sl);
+    for(len=0;len<4;len++){
+        lane.x[0]=lane_h[len];
+        lane.x[1]=lane_l[len];
+        FP_FN(add)(r,r,&lane);
+    }
+    return i;
+}
+#endif
+
+#if FP_N==4&&FP_FMA
+//quad-double arithmetic on four values at once, one per lane, a component per vector (v[0] the leading ones)
+static inline __m256d FP_FN(v_two_sum)(__m256d a, __m256d b, __m256d *err){
+    __m256d s=_mm256_add_pd(a,b);
+    __m256d bb=_mm256_sub_pd(s,a);
+    *err=_mm256_add_pd(_mm256_sub_pd(a,_mm256_sub_pd(s,bb)),_mm256_sub_pd(b,bb));
+    return s;
+}
+
+static inline __m256d FP_FN(v_quick_two_sum)(__m256d a, __m256d b, __m256d *err){
+    __m256d s=_mm256_add_pd(a,b);
+    *err=_mm256_sub_pd(b,_mm256_sub_pd(s,a));
+    return s;
+}
+
+static inline __m256d FP_FN(v_two_prod)(__m256d a, __m256d b, __m256d *err){
+    __m256d p=_mm256_mul_pd(a,b);
+    *err=_mm256_fmsub_pd(a,b,p);
+    return p;
+}
+
+static inline void FP_FN(v_three_sum)(__m256d *a, __m256d *b, __m256d *c){
+    __m256d t1,t2,t3;
+    t1=FP_FN(v_two_sum)(*a,*b,&t2);
+    *a=FP_FN(v_two_sum)(*c,t1,&t3);
+    *b=FP_FN(v_two_sum)(t2,t3,c);
+}
+
+static inline void FP_FN(v_three_sum2)(__m256d *a, __m256d *b, __m256d *c){
+    __m256d t1,t2,t3;
+    t1=FP_FN(v_two_sum)(*a,*b,&t2);
+    *a=FP_FN(v_two_sum)(*c,t1,&t3);
+    *b=_mm256_add_pd(t2,t3);
+}
+
+//renorm5 without its zero tests: a component that cancels exactly leaves a zero in the middle of the
+//expansion instead of being skipped (still exact, the value is just spread over fewer components)
+static inline void FP_FN(v_renorm5)(__m256d *c, __m256d *r){
+    __m256d s;
+    s=FP_FN(v_quick_two_sum)(c[3],c[4],&c[4]);
+    s=FP_FN(v_quick_two_sum)(c[2],s,&c[3]);
+    s=FP_FN(v_quick_two_sum)(c[1],s,&c[2]);
+    r[0]=FP_FN(v_quick_two_sum)(c[0],s,&c[1]);
+    r[1]=FP_FN(v_quick_two_sum)(c[1],c[2],&r[2]);
+    r[2]=FP_FN(v_quick_two_sum)(r[2],c[3],&r[3]);
+    r[3]=_mm256_add_pd(r[3],c[4]);
+}
+
+//r=a*b, as mul
+static inline void FP_FN(v_mul)(__m256d *r, const __m256d *a, const __m256d *b){
+    __m256d p0,p1,p2,p3,p4,p5,q0,q1,q2,q3,q4,q5,s0,s1,s2,t0,t1;
+    __m256d c[5];
+    p0=FP_FN(v_two_prod)(a[0],b[0],&q0);
+    p1=FP_FN(v_two_prod)(a[0],b[1],&q1);
+    p2=FP_FN(v_two_prod)(a[1],b[0],&q2);
+    p3=FP_FN(v_two_prod)(a[0],b[2],&q3);
+    p4=FP_FN(v_two_prod)(a[1],b[1],&q4);
+    p5=FP_FN(v_two_prod)(a[2],b[0],&q5);
+    FP_FN(v_three_sum)(&p1,&p2,&q0);
+    FP_FN(v_three_sum)(&p2,&q1,&q2);
+    FP_FN(v_three_sum)(&p3,&p4,&p5);
+    s0=FP_FN(v_two_sum)(p2,p3,&t0);
+    s1=FP_FN(v_two_sum)(q1,p4,&t1);
+    s2=_mm256_add_pd(q2,p5);
+    s1=FP_FN(v_two_sum)(s1,t0,&t0);
+    s2=_mm256_add_pd(s2,_mm256_add_pd(t0,t1));
+    t0=_mm256_mul_pd(a[0],b[3]);
+    t0=_mm256_fmadd_pd(a[1],b[2],t0);
+    t0=_mm256_fmadd_pd(a[2],b[1],t0);
+    t0=_mm256_fmadd_pd(a[3],b[0],t0);
+    t0=_mm256_add_pd(_mm256_add_pd(t0,q0),_mm256_add_pd(_mm256_add_pd(q3,q4),q5));
+    s1=_mm256_add_pd(s1,t0);
+    c[0]=p0; c[1]=p1; c[2]=s0; c[3]=s1; c[4]=s2;
+    FP_FN(v_renorm5)(c,r);
+}
+
+//r=a+b, as add
+static inline void FP_FN(v_add)(__m256d *r, const __m256d *a, const __m256d *b){
+    __m256d s[5],t0,t1,t2,t3;
+    s[0]=FP_FN(v_two_sum)(a[0],b[0],&t0);
+    s[1]=FP_FN(v_two_sum)(a[1],b[1],&t1);
+    s[2]=FP_FN(v_two_sum)(a[2],b[2],&t2);
+    s[3]=FP_FN(v_two_sum)(a[3],b[3],&t3);
+    s[1]=FP_FN(v_two_sum)(s[1],t0,&t0);
+    FP_FN(v_three_sum)(&s[2],&t0,&t1);
+    FP_FN(v_three_sum2)(&s[3],&t0,&t2);
+    s[4]=_mm256_add_pd(_mm256_add_pd(t0,t1),t3);
+    FP_FN(v_renorm5)(s,r);
+}
+
+//load x[0..3] with the components transposed into v (v[c] holds component c of the four entries)
+static inline void FP_FN(v_load)(__m256d *v, const FP_T *x){
+    __m256d r0,r1,r2,r3,t0,t1,t2,t3;
+    r0=_mm256_loadu_pd(x[0].x);
+    r1=_mm256_loadu_pd(x[1].x);
+    r2=_mm256_loadu_pd(x[2].x);
+    r3=_mm256_loadu_pd(x[3].x);
+    t0=_mm256_unpacklo_pd(r0,r1);
+    t1=_mm256_unpackhi_pd(r0,r1);
+    t2=_mm256_unpacklo_pd(r2,r3);
+    t3=_mm256_unpackhi_pd(r2,r3);
+    v[0]=_mm256_permute2f128_pd(t0,t2,0x20);
+    v[1]=_mm256_permute2f128_pd(t1,t3,0x20);
+    v[2]=_mm256_permute2f128_pd(t0,t2,0x31);
+    v[3]=_mm256_permute2f128_pd(t1,t3,0x31);
+}
+
+//quad-double dot product of the first len-len%4 entries, four at a time (one per lane). r must be zero.
+//returns the number of entries done
+int FP_FN(dot_avx2)(FP_T *r, int len, const FP_T *x, const FP_T *y){
+    __m256d xv[4],yv[4],p[4],sum[4];
+    double lanes[4][4];
+    FP_T lane;
+    int i,c;
+    if(len<4)
+        return 0;
+    for(c=0;c<4;c++)
+        sum[c]=_mm256_setzero_pd();
+    for(i=0;i+4<=len;i+=4){
+        FP_FN(v_load)(xv,&x[i]);
+        FP_FN(v_load)(yv,&y[i]);
+        FP_FN(v_mul)(p,xv,yv);
+        FP_FN(v_add)(sum,sum,p);
+    }
+    for(c=0;c<4;c++)
+        _mm256_storeu_pd(lanes[c],sum[c]);
+    for(i=0;i<4;i++){
+        for(c=0;c<4;c++)
+            lane.x[c]=lanes[c][i];
+        FP_FN(add)(r,r,&lane);
+    }
+    return len-len%4;
+}
+#endif
+
+//gram schmidt of fbasis (the basis as expansions) from vector start on, as gram_schmidt() does.
+//onorm[k] is set to |obasis[k]|^2, oinv[k] to its inverse
+void FP_FN(gram_schmidt)(int start, int dim, int nvec, FP_T *fbasis, FP_T *obasis, FP_T *onorm, FP_T *oinv){
+    FP_T mu,p,one;
+    int j,k,s;
+    FP_FN(set_d)(&one,1);
+    for(k=start;k<nvec;k++){
+        for(s=0;s<dim;s++)
+            obasis[k*dim+s]=fbasis[k*dim+s];
+        //substract off projections
+        for(j=0;j<k;j++){
+            FP_FN(dot)(&mu,dim,&obasis[k*dim],&obasis[j*dim]);
+            FP_FN(mul)(&mu,&mu,&oinv[j]);
+            for(s=0;s<dim;s++){
+                FP_FN(mul)(&p,&mu,&obasis[j*dim+s]);
+                FP_FN(sub)(&obasis[k*dim+s],&obasis[k*dim+s],&p);
+            }
+        }
+        FP_FN(dot)(&onorm[k],dim,&obasis[k*dim],&obasis[k*dim]);
+        FP_FN(div)(&oinv[k],&one,&onorm[k]);
+    }
+}
+
+//LLL_ctl with the gram schmidt data in expansions (same steps, counts added to stats).
+//basis entries must fit (see lll_fp_fits). returns as LLL_ctl
+//with lll_block_size set, bases of at least twice that many vectors go through LLL_segment first
+int FP_FN(LLL)(int dim, int nvec, mpz_t *basis, double delta, lll_control *ctl, lll_stats *stats){
+    int i,done;
+    FP_T *fbasis;
+    mpz_t rest,tmp;
+
+    if(lll_block_size>1&&nvec>=2*lll_block_size)
+        return FP_FN(LLL_segment)(dim,nvec,basis,delta,lll_block_size,ctl,stats);
+    fbasis=malloc(dim*nvec*sizeof(FP_T)); //basis as expansions (exact up to the first FP_N components)
+    mpz_init(rest);
+    mpz_init(tmp);
+    for(i=0;i<dim*nvec;i++)
+        FP_FN(set_z)(&fbasis[i],basis[i],rest,tmp);
+    done=FP_FN(LLL_rows)(dim,nvec,basis,fbasis,0,NULL,NULL,NULL,delta,0,ctl,stats);
+    free(fbasis);
+    mpz_clear(rest);
+    mpz_clear(tmp);
+    return done;
+}
+
+//the LLL loop on basis, with fbasis its rows as expansions. with prefix>0, basis is a window of a larger basis whose
+//first prefix rows are pbasis, with g.s. vectors pobasis and inverse squared norms poinv; those are only read: the
+//window rows are size reduced against them as well, and their own g.s. vectors are taken orthogonally to them (see
+//project). stops after max_iterations iterations if that is positive. returns as LLL_ctl
+int FP_FN(LLL_rows)(int dim, int nvec, mpz_t *basis, FP_T *fbasis, int prefix, mpz_t *pbasis, FP_T *pobasis, FP_T *poinv, double delta, long max_iterations, lll_control *ctl, lll_stats *stats){
+    int j,k,s;
+    long iterations=0;
+    FP_T mu,abs_mu,half,fdelta,lhs,rhs;
+    FP_T *obasis=malloc(dim*nvec*sizeof(FP_T)); //g.s. basis
+    FP_T *onorm=malloc(nvec*sizeof(FP_T)); //squared norms of the g.s. vectors
+    FP_T *oinv=malloc(nvec*sizeof(FP_T)); //and their inverses
+    FP_T *proj=fbasis; //rows projected orthogonally to the prefix
+    mpz_t rnd; mpz_init(rnd);
+    mpz_t dummyz; mpz_init(dummyz);
+    mpz_t rest; mpz_init(rest);
+
+    if(prefix>0){
+        proj=malloc(dim*nvec*sizeof(FP_T));
+        for(k=0;k<nvec;k++)
+            FP_FN(project)(dim,k,basis,fbasis,proj,prefix,pbasis,pobasis,poinv,stats);
+    }
+    FP_FN(gram_schmidt)(0,dim,nvec,proj,obasis,onorm,oinv);
+    stats->gs_updates++;
+    FP_FN(set_d)(&half,0.5);
+    FP_FN(set_d)(&fdelta,delta);
+    k=1;
+
+    //LLL loop
+    while(k<nvec&&(max_iterations<=0||iterations<max_iterations)){
+        if(++iterations%LLL_CHECK_EVERY==0&&(lll_should_stop_after(ctl,LLL_CHECK_EVERY)||lll_accept(ctl,basis,dim)))
+            break;
+        for(j=k-1;j>=0;j--){
+            FP_FN(dot)(&mu,dim,&proj[k*dim],&obasis[j*dim]);
+            FP_FN(mul)(&mu,&mu,&oinv[j]);
+            FP_FN(neg)(&abs_mu,&mu);
+            if(FP_FN(sgn)(&mu)>=0)
+                abs_mu=mu;
+            if(FP_FN(cmp)(&abs_mu,&half)>0){
+                FP_FN(get_z)(rnd,&mu,dummyz);
+                for(s=0;s<dim;s++){
+                    //set basis[k][s]=basis[k][s]-rnd*basis[j][s];
+                    mpz_mul(dummyz,rnd,basis[j*dim+s]);
+                    mpz_sub(basis[k*dim+s],basis[k*dim+s],dummyz);
+                    FP_FN(set_z)(&fbasis[k*dim+s],basis[k*dim+s],rest,dummyz);
+                }
+                if(prefix>0)
+                    FP_FN(project)(dim,k,basis,fbasis,proj,prefix,pbasis,pobasis,poinv,stats);
+                FP_FN(gram_schmidt)(k,dim,nvec,proj,obasis,onorm,oinv);
+                stats->size_reductions++;
+                stats->gs_updates++;
+            }
+        }
+
+        //lovasz condition: |obasis[k]|^2 >= (delta-mu^2)*|obasis[k-1]|^2
+        FP_FN(dot)(&mu,dim,&proj[k*dim],&obasis[(k-1)*dim]);
+        FP_FN(mul)(&mu,&mu,&oinv[k-1]);
+        FP_FN(mul)(&mu,&mu,&mu);
+        FP_FN(sub)(&mu,&fdelta,&mu);
+        FP_FN(mul)(&rhs,&mu,&onorm[k-1]);
+        lhs=onorm[k];
+        if(FP_FN(cmp)(&lhs,&rhs)>=0){
+            k++;
+        }
+        else{
+            //swap basis[k] and basis[k-1]
+            for(s=0;s<dim;s++){
+                mpz_swap(basis[k*dim+s],basis[(k-1)*dim+s]);
+                mu=fbasis[k*dim+s];
+                fbasis[k*dim+s]=fbasis[(k-1)*dim+s];
+                fbasis[(k-1)*dim+s]=mu;
+                if(prefix>0){
+                    mu=proj[k*dim+s];
+                    proj[k*dim+s]=proj[(k-1)*dim+s];
+                    proj[(k-1)*dim+s]=mu;
+                }
+            }
+            FP_FN(gram_schmidt)(k-1,dim,nvec,proj,obasis,onorm,oinv);
+            stats->swaps++;
+            stats->gs_updates++;
+            k=MAX(k-1,1);
+        }
+    }
+
+    if(prefix>0)
+        free(proj);
+    free(obasis);
+    free(onorm);
+    free(oinv);
+    mpz_clear(rnd);
+    mpz_clear(dummyz);
+    mpz_clear(rest);
+    stats->iterations+=iterations;
+    return k>=nvec||(ctl!=NULL&&ctl->accepted);
+}
+
+//size reduce row k of basis (a window, see LLL_rows) against the prefix rows pbasis, then set proj[k] to its projection
+//orthogonally to them. proj[k] is read from the integer row every time rather than updated along with it, which
+//would lose precision at each cancellation. a mu with more bits than half the expansion isn't rounded exactly, so
+//the pass is then repeated, as long as it makes the row smaller. returns 0 (and stops reducing) if a step would
+//take the row past LLL_FP_MAX_BITS, which only happens when the g.s. data isn't accurate
+int FP_FN(project)(int dim, int k, mpz_t *basis, FP_T *fbasis, FP_T *proj, int prefix, mpz_t *pbasis, FP_T *pobasis, FP_T *poinv, lll_stats *stats){
+    int j,s,again,bits,last,ok;
+    FP_T mu,abs_mu,half,big,p;
+    mpz_t rnd; mpz_init(rnd);
+    mpz_t dummyz; mpz_init(dummyz);
+    mpz_t rest; mpz_init(rest);
+
+    FP_FN(set_d)(&half,0.5);
+    FP_FN(set_d)(&big,ldexp(1,26*FP_N));
+    bits=0;
+    ok=1;
+    do{
+        again=0;
+        for(j=prefix-1;j>=0&&ok;j--){
+            FP_FN(dot)(&mu,dim,&fbasis[k*dim],&pobasis[j*dim]);
+            FP_FN(mul)(&mu,&mu,&poinv[j]);
+            FP_FN(neg)(&abs_mu,&mu);
+            if(FP_FN(sgn)(&mu)>=0)
+                abs_mu=mu;
+            if(FP_FN(cmp)(&abs_mu,&half)>0){
+                FP_FN(get_z)(rnd,&mu,dummyz);
+                for(s=0;s<dim&&ok;s++)
+                    ok=mpz_sizeinbase(rnd,2)+mpz_sizeinbase(pbasis[j*dim+s],2)<=LLL_FP_MAX_BITS;
+                for(s=0;s<dim&&ok;s++){
+                    mpz_mul(dummyz,rnd,pbasis[j*dim+s]);
+                    mpz_sub(basis[k*dim+s],basis[k*dim+s],dummyz);
+                    FP_FN(set_z)(&fbasis[k*dim+s],basis[k*dim+s],rest,dummyz);
+                }
+                stats->size_reductions+=ok;
+                again|=FP_FN(cmp)(&abs_mu,&big)>0;
+            }
+        }
+        last=bits;
+        bits=0;
+        for(s=0;s<dim;s++)
+            bits=MAX(bits,(int)mpz_sizeinbase(basis[k*dim+s],2));
+    }while(ok&&again&&(last==0||bits<last));
+    for(s=0;s<dim;s++)
+        proj[k*dim+s]=fbasis[k*dim+s];
+    for(j=0;j<prefix;j++){
+        FP_FN(dot)(&mu,dim,&proj[k*dim],&pobasis[j*dim]);
+        FP_FN(mul)(&mu,&mu,&poinv[j]);
+        for(s=0;s<dim;s++){
+            FP_FN(mul)(&p,&mu,&pobasis[j*dim+s]);
+            FP_FN(sub)(&proj[k*dim+s],&proj[k*dim+s],&p);
+        }
+    }
+    mpz_clear(rnd);
+    mpz_clear(dummyz);
+    mpz_clear(rest);
+    return ok;
+}
+
+//size reduce the whole basis, row by row, and set the g.s. data (obasis, onorm, oinv) along the way. unlike
+//gram_schmidt on the rows as they are, this only takes projections against rows already size reduced, which keeps
+//them accurate when the basis is far from size reduced (as it is after the segments of LLL_segment change).
+//returns 0 if project fails, or if some g.s. norm is smaller than one before it by more bits than the expansion has
+//beyond a double: its row cancels that much against the longer ones (g.s. norms growing along the basis cost nothing)
+int FP_FN(size_reduce)(int dim, int nvec, mpz_t *basis, FP_T *fbasis, FP_T *obasis, FP_T *onorm, FP_T *oinv, lll_stats *stats){
+    int k,e,hi;
+    FP_T one;
+    FP_FN(set_d)(&one,1);
+    hi=INT_MIN;
+    stats->gs_updates++;
+    for(k=0;k<nvec;k++){
+        if(!FP_FN(project)(dim,0,&basis[k*dim],&fbasis[k*dim],&obasis[k*dim],k,basis,obasis,oinv,stats))
+            return 0;
+        FP_FN(dot)(&onorm[k],dim,&obasis[k*dim],&obasis[k*dim]);
+        FP_FN(div)(&oinv[k],&one,&onorm[k]);
+        if(!(onorm[k].x[0]>0)) //(also nan)
+            return 0;
+        frexp(onorm[k].x[0],&e);
+        hi=MAX(hi,e);
+        if(hi-e>2*53*(FP_N-1))
+            return 0;
+    }
+    return 1;
+}
+
+//run the segment reductions of a segment_job, each on the rows of its segment copied to wbasis, wfbasis
+void *FP_FN(segment_thread)(void *arg){
+    FP_FN(segment_job) *job=arg;
+    int dim=job->dim;
+    int i,k,s,e;
+    for(k=job->first;k<job->count;k+=job->step){
+        s=job->seg[2*k];
+        e=job->seg[2*k+1];
+        for(i=s*dim;i<e*dim;i++){
+            mpz_set(job->wbasis[i],job->basis[i]);
+            job->wfbasis[i]=job->fbasis[i];
+        }
+        FP_FN(LLL_rows)(dim,e-s,&job->wbasis[s*dim],&job->wfbasis[s*dim],job->projected ? s : 0,job->basis,job->obasis,job->oinv,job->delta,SEGMENT_MAX_ITERATIONS,NULL,&job->stats);
+    }
+    return NULL;
+}
+
+//segment LLL: the basis is cut into segments of block vectors, and each segment is LLL reduced on its own, with the
+//rows before it as the prefix of LLL_rows. that changes neither the span of the rows before a segment nor the
+//projections of the rows after it, so the segments are independent and run on separate threads (on copies of their
+//rows, the basis itself being only read until they are done); their gram schmidt updates also only cover the segment,
+//not the whole rest of the basis. the segments alternate between starting at 0 and at block/2, so that every pair of
+//neighbours is in some segment, until a round of both makes no swap (or after SEGMENT_MAX_ROUNDS). then every Lovasz
+//condition holds, and the usual loop over the whole basis (which also checks it) has little left to do. a phase whose
+//prefixes are too ill conditioned for the expansion (see size_reduce), or whose entries no longer fit (lll_fp_fits),
+//ends the rounds, and the full pass then starts from the basis before the phase that led there. returns as LLL_ctl
+int FP_FN(LLL_segment)(int dim, int nvec, mpz_t *basis, double delta, int block, lll_control *ctl, lll_stats *stats){
+    int i,k,s,e,t,round,phase,count,threads,projected,conditioned,done,fits;
+    long swaps,iterations;
+    FP_T *fbasis=malloc(dim*nvec*sizeof(FP_T)); //basis as expansions
+    FP_T *obasis=malloc(dim*nvec*sizeof(FP_T)); //g.s. basis
+    FP_T *onorm=malloc(nvec*sizeof(FP_T));
+    FP_T *oinv=malloc(nvec*sizeof(FP_T));
+    FP_T *wfbasis=malloc(dim*nvec*sizeof(FP_T)); //working copies of the segments
+    mpz_t *wbasis=malloc(dim*nvec*sizeof(mpz_t));
+    mpz_t *saved=malloc(dim*nvec*sizeof(mpz_t)); //basis before the segments of the last phase
+    int *seg=malloc(2*(nvec/block+2)*sizeof(int));
+    FP_FN(segment_job) *job;
+    pthread_t *thread;
+    mpz_t rest; mpz_init(rest);
+    mpz_t tmp; mpz_init(tmp);
+
+    for(i=0;i<dim*nvec;i++){
+        mpz_init(wbasis[i]);
+        mpz_init(saved[i]);
+    }
+    threads=MIN(lll_fp_threads(),nvec/block+1);
+    job=malloc(threads*sizeof(FP_FN(segment_job)));
+    thread=malloc(threads*sizeof(pthread_t));
+    conditioned=1;
+    done=-1;
+    for(round=0;round<SEGMENT_MAX_ROUNDS&&done<0;round++){
+        swaps=0;
+        for(phase=0;phase<2&&done<0;phase++){
+            //segments [0,block/2) (odd phases), then block vectors each
+            count=0;
+            for(s=0;s<nvec;s=e){
+                e=MIN(nvec,(s==0&&phase) ? block/2 : s+block);
+                if(e-s>1){
+                    seg[2*count]=s;
+                    seg[2*count+1]=e;
+                    count++;
+                }
+            }
+            //the first phase reduces the segments as lattices of their own: projecting away from rows that aren't
+            //reduced yet would need far more precision
+            projected=round>0||phase>0;
+            if((fits=lll_fp_fits(dim*nvec,basis))){
+                for(i=0;i<dim*nvec;i++)
+                    FP_FN(set_z)(&fbasis[i],basis[i],rest,tmp);
+                if(projected)
+                    conditioned=FP_FN(size_reduce)(dim,nvec,basis,fbasis,obasis,onorm,oinv,stats);
+            }
+            if(!fits||!conditioned){
+                //back to the basis before the last phase, which the full pass can take on (a basis that fails here
+                //can be out of reach of the full pass too)
+                for(i=0;i<dim*nvec&&projected;i++)
+                    mpz_swap(basis[i],saved[i]);
+                conditioned=0;
+                break;
+            }
+            for(i=0;i<dim*nvec;i++)
+                mpz_set(saved[i],basis[i]);
+
+            //reduce the segments, the calling thread being one of the threads
+            for(t=0;t<threads;t++){
+                job[t].dim=dim;
+                job[t].basis=basis;
+                job[t].fbasis=fbasis;
+                job[t].obasis=obasis;
+                job[t].oinv=oinv;
+                job[t].wbasis=wbasis;
+                job[t].wfbasis=wfbasis;
+                job[t].seg=seg;
+                job[t].count=count;
+                job[t].first=t;
+                job[t].step=threads;
+                job[t].projected=projected;
+                job[t].delta=delta;
+                job[t].stats=(lll_stats){0,0,0,0};
+            }
+            for(t=1;t<threads;t++){
+                if(pthread_create(&thread[t],NULL,FP_FN(segment_thread),&job[t])!=0)
+                    break;
+            }
+            for(i=0;i<threads;i++){
+                if(i==0||i>=t) //(jobs whose thread couldn't be started run here)
+                    FP_FN(segment_thread)(&job[i]);
+            }
+            iterations=0;
+            for(i=0;i<threads;i++){
+                if(i>0&&i<t)
+                    pthread_join(thread[i],NULL);
+                iterations+=job[i].stats.iterations;
+                swaps+=job[i].stats.swaps;
+                stats->iterations+=job[i].stats.iterations;
+                stats->swaps+=job[i].stats.swaps;
+                stats->size_reductions+=job[i].stats.size_reductions;
+                stats->gs_updates+=job[i].stats.gs_updates;
+            }
+            for(k=0;k<count;k++){
+                for(i=seg[2*k]*dim;i<seg[2*k+1]*dim;i++)
+                    mpz_swap(basis[i],wbasis[i]);
+            }
+            if(lll_should_stop_after(ctl,(int)iterations))
+                done=0;
+            else if(lll_accept(ctl,basis,dim))
+                done=1;
+        }
+        if(swaps==0||!conditioned)
+            break;
+    }
+
+    //the whole basis (whatever the rounds left)
+    if(done<0&&!lll_fp_fits(dim*nvec,basis)){
+        for(i=0;i<dim*nvec;i++)
+            mpz_swap(basis[i],saved[i]);
+    }
+    if(done<0){
+        for(i=0;i<dim*nvec;i++)
+            FP_FN(set_z)(&fbasis[i],basis[i],rest,tmp);
+        done=FP_FN(LLL_rows)(dim,nvec,basis,fbasis,0,NULL,NULL,NULL,delta,0,ctl,stats);
+    }
+
+    for(i=0;i<dim*nvec;i++){
+        mpz_clear(wbasis[i]);
+        mpz_clear(saved[i]);
+    }
+    free(wbasis);
+    free(saved);
+    free(wfbasis);
+    free(fbasis);
+    free(obasis);
+    free(onorm);
+    free(oinv);
+    free(seg);
+    free(job);
+    free(thread);
+    mpz_clear(rest);
+    mpz_clear(tmp);
+    return done;
+}
+
+#undef FP_T
+#undef FP_FN
+#undef FP_CAT
+#undef FP_CAT2
+#undef FP
+#undef FP_N
+#undef FP_FMA
@@ -7,7 +7,6 @@
 //    07.2018
 
 //------------TODO------------------//
-//allow for non-monic polynomials
 //implement irreducibility tests
 //			- Eisenstein (plus shifts?)
 //      - Perron's criterion
@@ -15,23 +14,252 @@
 //      - reverting
 //      - Newton polygons?
 
-
+#define BIN_MAX_LEN 65536 //longest binary polynomial read (the input is untrusted, see read_bin_len)
+#define BIN_MAX_WORDS 65536 //largest coefficient of a binary polynomial read, in 64-bit words (about 1.2M digits)
+#define HEIGHT_SLACK 64 //bits added to the precision estimated from the height of a polynomial (see height_precision)
+
+//list of factors, stored back to back in one pool of coefficients, each with its own degree
+//(so memory is proportional to the size of the output, not to the number of factors times the input length)
+typedef struct {
+    int count; //number of factors
+    int cap; //room for this many factors before growing
+    int *degree; //degree of each factor
+    int *offset; //factor k is coefs[offset[k]],...,coefs[offset[k]+degree[k]]
+    int *multiplicity;
+    mpz_t *coefs; //coefficient pool
+    int used; //coefficients of the pool in use
+    int pool; //coefficients allocated
+} factor_list;
+
+void factor_list_init(factor_list *fl, int cap, int pool);
+void factor_list_clear(factor_list *fl);
+int factor_list_reserve(factor_list *fl, int deg);
+int factor_list_add(factor_list *fl, mpz_t *p, int deg, int multiplicity);
+void factor_list_set(factor_list *fl, int k, mpz_t *p, int deg);
+void factor_list_swap(factor_list *fl, int j, int k);
+void factor_list_truncate(factor_list *fl, int count);
+mpz_t *factor_coefs(const factor_list *fl, int k);
 void print_poly(int len,const  mpz_t *x,int newline);
-void print_factors(mpz_t *factors,int *multiplicities, int num_factors, int poly_len,int trivial_power,int newline);
+void print_factors(const factor_list *fl, int first, int num_factors, int trivial_power, int newline);
+void print_factors_json(const factor_list *fl, int complete, int msec_time);
+void print_factor_json(const mpz_t *factor, int deg, int multiplicity);
+void write_u32(FILE *f, unsigned long x);
+int read_u32(FILE *f, unsigned long *x);
+int write_bin_poly(FILE *f, int len, const mpz_t *p);
+int read_bin_len(FILE *f);
+int read_bin_poly(FILE *f, mpz_t *p, int len);
+void print_factors_bin(const factor_list *fl, int complete);
 void evaluate_cx(mpz_t *p, int len, const mpc_t input, mpc_t output, int PRECISION);
 int degree(mpz_t *p, int len);
 int degree_q(mpq_t *p, int len);
-int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int PRECISION);
+int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int PRECISION, lll_control *ctl);
+void root_radius_cx(mpz_t *p, int len, mpc_t root, mpfr_t rad, int PRECISION);
+int inverse_radius_cx(mpc_t root, mpfr_t rad, mpfr_t rad_inv, int PRECISION);
 int polydivide(mpz_t *p,mpz_t *d,mpz_t *out,int len);
 int polydivide_r(mpq_t *p,mpq_t *d,mpq_t *r,int len);
 void gcd(mpz_t *poly1, mpz_t *poly2, mpz_t *gcd, int poly_len);
-int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,int verbosity, double d_delta, int stop_deg);
-int factorize(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors,int verbosity, double delta, int stop_deg);
-int factorize_full(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors, int *multiplicities,int verbosity, double delta, int stop_deg);
-int monic_slide(int len, mpz_t *p);
-int monic_slide_dont_multiply(int len, mpz_t *p);
+#include "factor_db.h" //table of known small irreducible factors (uses the functions above)
+#include "checkpoint.h" //saving and resuming the state of factorize (uses the functions above)
+#include <stdarg.h>
+
+//time (seconds) spent in each phase of one find_factor_cx call, and what LLL did meanwhile
+typedef struct {
+    int input_degree; //degree of the polynomial searched
+    int factor_degree; //degree of the factor found, 0 if none
+    double root; //rootfind_cx (including restarts)
+    double basis; //create_basis_cx
+    double lll; //LLL_ctl
+    double divide; //primitive_slide + mod_screen_divides + polydivide
+    int lll_calls; //number of degrees tried
+    lll_stats lll_counts;
+} factor_stats;
+
+//profile of a whole run, filled in if ctx->stats is set
+typedef struct {
+    factor_stats *factors; //one entry per find_factor_cx call
+    int count;
+    int cap;
+    double squarefree; //gcd(p,p') and division by it
+    double database; //factor_db_divide
+    double multiplicity; //counting multiplicities
+} run_stats;
+
+//run-time state shared by factorize_full -> factorize -> find_factor_cx. may be passed as NULL
+typedef struct {
+    const factor_db *db; //known small factors to divide out first (NULL if none)
+    int progress; //emit progress events on stderr
+    lll_control ctl; //deadline/cancellation, checked in LLL and rootfind_cx
+    int cofactor; //if ctl expired: index of the unfactored cofactor in the list of factors, -1 otherwise
+    run_stats *stats; //profiling counters (NULL if not profiling)
+    checkpoint *ck; //progress saved for resuming (NULL if not checkpointing)
+    int relation; //how find_factor_cx looks for the minimal polynomial of a root: RELATION_LLL or RELATION_PSLQ
+    uint64_t seed; //of the random starting points of rootfind_cx (DEFAULT_SEED if ctx is NULL)
+} factor_ctx;
+
+#define DEFAULT_SEED 1 //of the random starting points of rootfind_cx, unless -seed is given
+
+//splitmix64 generator: a single word of state, and rng_split derives independent streams from a key, so that every
+//root attempt gets its own stream whatever order (or thread) it runs in
+typedef struct {
+    uint64_t state;
+} rng64;
+
+//candidate test run inside LLL by find_factor_cx (see divisor_accept)
+typedef struct {
+    int deg; //degree searched: a basis vector holds deg+1 coefficients, then the two root columns
+    int reversed; //the lattice is built on 1/root: coefficient i of a vector is that of x^(deg-i)
+    int deg_p; //degree of the polynomial being factored
+    mpz_srcptr lc; //its leading coefficient (a factor's must divide it)
+    uint64_t *p; //its coefficients mod FACTOR_DB_PRIME
+    uint64_t *d; //scratch, deg_p+1 words
+    uint64_t *work; //scratch, deg_p+1 words
+} divisor_test;
+
+//residues of a polynomial modulo SCREEN_PRIMES word-size primes, to screen candidate divisors before polydivide
+//(see mod_screen_divides). the residues of coefficient i are side by side, p[i*SCREEN_PRIMES+l] being its
+//residue mod screen_primes[l], so that the division loops run over all primes at once and vectorize
+#define SCREEN_PRIMES 4
+#define SCREEN_MAX_DEG 1023 //divisors of higher degree aren't screened (the lazy reduction would overflow)
+typedef struct {
+    int deg_p; //degree of the polynomial
+    uint64_t *p; //its residues, (deg_p+1)*SCREEN_PRIMES words
+    uint64_t *d; //scratch for the candidate, same size
+    uint64_t *work; //scratch for the remainder, same size
+    uint64_t inv[SCREEN_PRIMES]; //floor((2^64-1)/prime), for screen_reduce
+    uint64_t r64[SCREEN_PRIMES]; //2^64 mod prime
+} mod_screen;
+
+const uint64_t screen_primes[SCREEN_PRIMES]={134217689,134217649,134217617,134217613}; //largest primes below 2^27
+
+void progress_event(const factor_ctx *ctx, const char *fmt, ...);
+uint64_t rng_next(rng64 *r);
+void rng_split(const rng64 *r, uint64_t key, rng64 *child);
+double rng_uniform(rng64 *r);
+uint64_t poly_hash(mpz_t *p, int len);
+uint64_t inverse_mod_p(uint64_t a, uint64_t prime);
+int divisor_accept(mpz_t *row, int dim, void *arg);
+int candidate_divides(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len, int len, mod_screen *screen);
+void mod_screen_init(mod_screen *s, mpz_t *poly, int len);
+void mod_screen_clear(mod_screen *s);
+int mod_screen_divides(mod_screen *s, mpz_t *d, int len);
+uint64_t screen_reduce(const mod_screen *s, uint64_t x, int l);
+void screen_residues(const mod_screen *s, const mpz_t z, uint64_t *out);
+lll_control *ctx_control(factor_ctx *ctx);
+factor_stats *stats_begin(factor_ctx *ctx, int input_degree);
+void stats_end(factor_ctx *ctx);
+void run_stats_clear(run_stats *rs);
+void print_stats_json(FILE *f, const run_stats *rs, int PRECISION, double delta, double wall_ms, double cpu_ms);
+int height_precision(mpz_t *poly, int poly_len, int deg);
+int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,int verbosity, double d_delta, int stop_deg, factor_ctx *ctx);
+int factorize(mpz_t *poly,int poly_len,int PRECISION,factor_list *fl,int verbosity, double delta, int stop_deg, factor_ctx *ctx);
+int factorize_full(mpz_t *poly,int poly_len,int PRECISION,factor_list *fl,int verbosity, double delta, int stop_deg, factor_ctx *ctx);
+void poly_content(mpz_t c, mpz_t *p, int len);
+int primitive_slide(int len, mpz_t *p);
 void derivative(mpz_t *p,mpz_t *pp,int poly_len);
 
+//allocate an empty list with room for cap factors and pool coefficients (both grow as needed)
+void factor_list_init(factor_list *fl, int cap, int pool){
+    int i;
+    fl->count=0;
+    fl->used=0;
+    fl->cap=MAX(cap,1);
+    fl->pool=MAX(pool,1);
+    fl->degree=malloc(fl->cap*sizeof(int));
+    fl->offset=malloc(fl->cap*sizeof(int));
+    fl->multiplicity=malloc(fl->cap*sizeof(int));
+    fl->coefs=malloc(fl->pool*sizeof(mpz_t));
+    for(i=0;i<fl->pool;i++)
+        mpz_init(fl->coefs[i]);
+}
+
+void factor_list_clear(factor_list *fl){
+    int i;
+    for(i=0;i<fl->pool;i++)
+        mpz_clear(fl->coefs[i]);
+    free(fl->coefs);
+    free(fl->degree);
+    free(fl->offset);
+    free(fl->multiplicity);
+    fl->count=0;
+    fl->used=0;
+    fl->cap=0;
+    fl->pool=0;
+}
+
+//reserve deg+1 coefficients at the end of the pool and return the offset of the first one
+int factor_list_reserve(factor_list *fl, int deg){
+    int i,new_pool;
+    mpz_t *coefs;
+    if(fl->used+deg+1>fl->pool){
+        //move the coefficients over to a bigger pool (by swapping, so no limbs are copied)
+        new_pool=MAX(2*fl->pool,fl->used+deg+1);
+        coefs=malloc(new_pool*sizeof(mpz_t));
+        for(i=0;i<new_pool;i++)
+            mpz_init(coefs[i]);
+        for(i=0;i<fl->used;i++)
+            mpz_swap(coefs[i],fl->coefs[i]);
+        for(i=0;i<fl->pool;i++)
+            mpz_clear(fl->coefs[i]);
+        free(fl->coefs);
+        fl->coefs=coefs;
+        fl->pool=new_pool;
+    }
+    fl->used+=deg+1;
+    return fl->used-deg-1;
+}
+
+//append a copy of p (of degree deg) to the list. return its index
+int factor_list_add(factor_list *fl, mpz_t *p, int deg, int multiplicity){
+    int i,k=fl->count;
+    if(k==fl->cap){
+        fl->cap*=2;
+        fl->degree=realloc(fl->degree,fl->cap*sizeof(int));
+        fl->offset=realloc(fl->offset,fl->cap*sizeof(int));
+        fl->multiplicity=realloc(fl->multiplicity,fl->cap*sizeof(int));
+    }
+    fl->offset[k]=factor_list_reserve(fl,deg);
+    fl->degree[k]=deg;
+    fl->multiplicity[k]=multiplicity;
+    for(i=0;i<=deg;i++)
+        mpz_set(fl->coefs[fl->offset[k]+i],p[i]);
+    fl->count++;
+    return k;
+}
+
+//replace factor k by a copy of p (of degree deg), keeping its multiplicity
+void factor_list_set(factor_list *fl, int k, mpz_t *p, int deg){
+    int i;
+    if(deg>fl->degree[k])
+        fl->offset[k]=factor_list_reserve(fl,deg); //the old coefficients stay unused in the pool
+    fl->degree[k]=deg;
+    for(i=0;i<=deg;i++)
+        mpz_set(fl->coefs[fl->offset[k]+i],p[i]);
+}
+
+//exchange factors j and k (only their entries, the coefficients stay where they are)
+void factor_list_swap(factor_list *fl, int j, int k){
+    int t;
+    t=fl->degree[j]; fl->degree[j]=fl->degree[k]; fl->degree[k]=t;
+    t=fl->offset[j]; fl->offset[j]=fl->offset[k]; fl->offset[k]=t;
+    t=fl->multiplicity[j]; fl->multiplicity[j]=fl->multiplicity[k]; fl->multiplicity[k]=t;
+}
+
+//forget all factors from index count on, and give back the end of the pool past the factors that are kept
+void factor_list_truncate(factor_list *fl, int count){
+    int k;
+    if(count>=fl->count)
+        return;
+    fl->count=count;
+    fl->used=0;
+    for(k=0;k<count;k++)
+        fl->used=MAX(fl->used,fl->offset[k]+fl->degree[k]+1);
+}
+
+//coefficients of factor k, lowest degree first
+mpz_t *factor_coefs(const factor_list *fl, int k){
+    return &fl->coefs[fl->offset[k]];
+}
+
 //print polynomial with coefficient list x. (pass newline=1 if \n is needed)
 void print_poly(int len,const  mpz_t *x,int newline){
     int i;
@@ -122,9 +350,9 @@ void print_poly(int len,const  mpz_t *x,int newline){
     mpz_clear(abs);
 }
 
-//print list of factors of a polynomial
+//print factors first,...,first+num_factors-1 of the list
 //trivial_power is the highest power of x dividing the polynomial
-void print_factors(mpz_t *factors,int *multiplicities, int num_factors, int poly_len,int trivial_power,int newline){
+void print_factors(const factor_list *fl, int first, int num_factors, int trivial_power, int newline){
     int j;
     if(trivial_power==1)
         printf("x");
@@ -133,18 +361,156 @@ void print_factors(mpz_t *factors,int *multiplicities, int num_factors, int poly
     if(newline)
         printf("\n");
     if(num_factors>0){
-        for(j=0;j<num_factors;j++){
+        for(j=first;j<first+num_factors;j++){
             printf("(");  
-            print_poly(poly_len,&factors[j*poly_len],0);
+            print_poly(fl->degree[j]+1,factor_coefs(fl,j),0);
             printf(")");
-            if(multiplicities[j]>1)
-                printf("^%d",multiplicities[j]);
+            if(fl->multiplicity[j]>1)
+                printf("^%d",fl->multiplicity[j]);
             if(newline)
                 printf("\n");
         } 
     }
 }
 
+//print list of factors as a json object: {"factors":[{"coefficients":[...],"multiplicity":m},...],"complete":true}
+//coefficients are written as decimal strings (lowest degree first) so that no precision is lost on the reading end
+//if complete is 0, the last factor is an unfactored cofactor and is written separately as "cofactor"
+//pass msec_time<0 to leave out the "time_ms" field
+void print_factors_json(const factor_list *fl, int complete, int msec_time){
+    int j,num_factors=fl->count;
+    printf("{\"factors\":[");
+    for(j=0;j<num_factors-!complete;j++){
+        if(j>0)
+            printf(",");
+        print_factor_json(factor_coefs(fl,j),fl->degree[j],fl->multiplicity[j]);
+    }
+    printf("]");
+    if(!complete&&num_factors>0){
+        printf(",\"cofactor\":");
+        print_factor_json(factor_coefs(fl,num_factors-1),fl->degree[num_factors-1],fl->multiplicity[num_factors-1]);
+    }
+    printf(",\"complete\":%s",complete ? "true" : "false");
+    if(msec_time>=0)
+        printf(",\"time_ms\":%d",msec_time);
+    printf("}\n");
+}
+
+//print a single factor (of degree deg) as {"coefficients":[...],"multiplicity":m}
+void print_factor_json(const mpz_t *factor, int deg, int multiplicity){
+    int i;
+    printf("{\"coefficients\":[");
+    for(i=0;i<=deg;i++){
+        if(i>0)
+            printf(",");
+        printf("\"");
+        mpz_out_str(stdout,10,factor[i]);
+        printf("\"");
+    }
+    printf("],\"multiplicity\":%d}",MAX(multiplicity,1));
+}
+
+//----------binary format---------------//
+//all integers are little-endian. A polynomial is stored as
+//    u32 len, followed by len coefficients (lowest degree first)
+//and a coefficient as
+//    i32 n, followed by |n| 64-bit words (least significant first), sign(n) = sign of the coefficient
+//so no base 10 conversion is done on either end (mpz_import/mpz_export only)
+
+//write unsigned 32-bit integer in little-endian order
+void write_u32(FILE *f, unsigned long x){
+    int i;
+    for(i=0;i<4;i++)
+        fputc((int)((x>>(8*i))&0xff),f);
+}
+
+//read unsigned 32-bit little-endian integer. return 0 on failure (EOF)
+int read_u32(FILE *f, unsigned long *x){
+    int i,c;
+    *x=0;
+    for(i=0;i<4;i++){
+        if((c=fgetc(f))==EOF)
+            return 0;
+        *x|=((unsigned long)c)<<(8*i);
+    }
+    return 1;
+}
+
+//write polynomial of length len in binary format. return 0 on failure
+int write_bin_poly(FILE *f, int len, const mpz_t *p){
+    int i;
+    size_t count;
+    unsigned char *buf;
+    void (*gmp_free)(void *,size_t); //mpz_export allocates with gmp's allocation functions
+    mp_get_memory_functions(NULL,NULL,&gmp_free);
+    write_u32(f,(unsigned long)len);
+    for(i=0;i<len;i++){
+        buf=mpz_export(NULL,&count,-1,8,-1,0,p[i]);
+        write_u32(f,(unsigned long)(mpz_sgn(p[i])<0 ? -(long)count : (long)count)&0xffffffffUL);
+        if(count>0 && fwrite(buf,8,count,f)!=count){
+            gmp_free(buf,8*count);
+            return 0;
+        }
+        if(buf!=NULL)
+            gmp_free(buf,8*count);
+    }
+    return 1;
+}
+
+//read the length header of a binary polynomial. return -1 on failure (or if it is longer than BIN_MAX_LEN)
+int read_bin_len(FILE *f){
+    unsigned long len;
+    if(!read_u32(f,&len)||len==0||len>BIN_MAX_LEN)
+        return -1;
+    return (int)len;
+}
+
+//read len coefficients of a binary polynomial (after its length header has been read with read_bin_len)
+//return 0 on failure (including coefficients of more than BIN_MAX_WORDS words)
+int read_bin_poly(FILE *f, mpz_t *p, int len){
+    int i;
+    long n;
+    unsigned long u;
+    unsigned char *buf;
+    for(i=0;i<len;i++){
+        if(!read_u32(f,&u))
+            return 0;
+        n=(u&0x80000000UL) ? (long)u-0x100000000L : (long)u; //sign extend
+        if(labs(n)>BIN_MAX_WORDS)
+            return 0;
+        buf=malloc(8*labs(n)+1);
+        if(buf==NULL)
+            return 0;
+        if(fread(buf,8,labs(n),f)!=(size_t)labs(n)){
+            free(buf);
+            return 0;
+        }
+        mpz_import(p[i],labs(n),-1,8,-1,0,buf);
+        if(n<0)
+            mpz_neg(p[i],p[i]);
+        free(buf);
+    }
+    return 1;
+}
+
+//write list of factors in binary format:
+//    u32 num_factors, then for each factor: u32 multiplicity, followed by the factor as a binary polynomial (trimmed to its degree)
+//    then u32 1 if the factorization is complete. otherwise u32 0, followed by the unfactored cofactor (the last factor) in the same
+//    form as a factor, i.e. its u32 multiplicity (1 unless it is a repeated part) and then the binary polynomial
+void print_factors_bin(const factor_list *fl, int complete){
+    int j,num_factors=fl->count;
+    write_u32(stdout,(unsigned long)(num_factors-!complete));
+    for(j=0;j<num_factors;j++){
+        if(j==num_factors-1&&!complete)
+            write_u32(stdout,0);
+        write_u32(stdout,(unsigned long)MAX(fl->multiplicity[j],1));
+        write_bin_poly(stdout,fl->degree[j]+1,factor_coefs(fl,j));
+    }
+    if(complete)
+        write_u32(stdout,1);
+    fflush(stdout);
+}
+
 //evaluate p(x), where the input is a complex number. Also Horner's method
 void evaluate_cx(mpz_t *p, int len, const mpc_t input, mpc_t output, int PRECISION){
     mpc_t bi; mpc_init2(bi,PRECISION);
@@ -166,7 +532,7 @@ void evaluate_cx(mpz_t *p, int len, const mpc_t input, mpc_t output, int PRECISI
 //considers the zero polynomial to have degree -1
 int degree(mpz_t *p, int len){
     int i=len-1;
-    while(mpz_sgn(p[i])==0&&i>=0)
+    while(i>=0&&mpz_sgn(p[i])==0)
         i--;
     return i;
 }
@@ -175,24 +541,27 @@ int degree(mpz_t *p, int len){
 //considers the zero polynomial to have degree -1
 int degree_q(mpq_t *p, int len){
     int i=len-1;
-    while(mpq_sgn(p[i])==0&&i>=0)
+    while(i>=0&&mpq_sgn(p[i])==0)
         i--;
     return i;
 }
 
 
 //find one complex root of p(x) using second order Newton's method (Halley's method). 
-//cubic convergence, stop when log10(|xn-x(n+1)|)<-log10_thresh 
-//returns 1 on success and 0 on failure (i.e. exceeding a certain amount of iterations without getting within the threshold of zero).
+//cubic convergence, stop when log10(|xn-x(n+1)|)<-log10_thresh+log10(max(1,|x(n+1)|)), i.e. relative to large roots
+//(the ulp of a root of a polynomial with huge coefficients can be far above 10^-log10_thresh), or once the steps stop
+//shrinking below sqrt of that: the rounding of p(x) then dominates them, and more steps don't improve x
+//returns 1 on success and 0 on failure (i.e. exceeding a certain amount of iterations without getting within the threshold of zero, or ctl expiring).
 //note: start value should not be totally real, since this iteration sends reals to reals
 //    : make sure p has no repeated roots (otherwise this isn't guaranteed to converge)
-//TODO: make exit condition depend on abs(Re(x)) and abs(Im(x))
-int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int PRECISION){
+int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int PRECISION, lll_control *ctl){
 
-    // If p is linear, the root is already known: -p[0]
+    // If p is linear, the root is already known: -p[0]/p[1]
     if(len<=2){
         mpc_set_z(root,p[0],MPC_RNDNN);
         mpc_ui_sub(root,0,root,MPC_RNDNN); //root = -root
+        if(len==2)
+            mpfr_div_z(mpc_realref(root),mpc_realref(root),p[1],MPFR_RNDN);
         return 1;
     }
 
@@ -202,6 +571,9 @@ int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int
     mpc_t quot; mpc_init2(quot,PRECISION);
     mpc_t dummy; mpc_init2(dummy,PRECISION);
     mpfr_t thresh; mpfr_init2(thresh,PRECISION);
+    mpfr_t scale; mpfr_init2(scale,PRECISION);
+    mpfr_t last; mpfr_init2(last,PRECISION); //previous diff
+    mpfr_t stall; mpfr_init2(stall,PRECISION);
     mpz_t *pp; pp=malloc((len)*sizeof(mpz_t)); //valgrind sees an issue here
     mpz_t *ppp; ppp=malloc((len)*sizeof(mpz_t)); //or here
     mpc_t eval_p; mpc_init2(eval_p,PRECISION);
@@ -222,9 +594,10 @@ int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int
         mpz_mul_ui(ppp[i],pp[i+1],i+1);
 
     mpfr_set_ui(diff,1,MPFR_RNDN);
+    mpfr_set_ui(scale,1,MPFR_RNDN);
     mpc_set(root,start,MPC_RNDNN);
-    int c=0;
-    while(mpfr_cmp(diff,thresh)>=0&&(c<max_iterates)){
+    int c=0,stalled=0;
+    while(mpfr_cmp(diff,scale)>=0&&!stalled&&(c<max_iterates)&&!lll_should_stop(ctl)){
         c++;
         evaluate_cx(p,len,root,eval_p,PRECISION);
         evaluate_cx(pp,len-1,root,eval_pp,PRECISION);
@@ -240,8 +613,17 @@ int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int
         mpc_mul(dummy,dummy,eval_pp,MPC_RNDNN);
         mpc_div(quot,dummy,quot,MPC_RNDNN);
 
+        mpfr_set(last,diff,MPFR_RNDN);
         mpc_abs(diff,quot,MPC_RNDNN);
         mpc_sub(root,root,quot,MPC_RNDNN);
+        mpc_abs(scale,root,MPC_RNDNN);
+        if(mpfr_cmp_ui(scale,1)<0)
+            mpfr_set_ui(scale,1,MPFR_RNDN);
+        mpfr_mul(scale,scale,thresh,MPFR_RNDN); //thresh*max(1,|root|)
+        //at the noise floor: no longer shrinking, although already below sqrt(scale)
+        mpfr_div_2ui(last,last,1,MPFR_RNDN);
+        mpfr_sqr(stall,diff,MPFR_RNDN);
+        stalled=c>1&&mpfr_cmp(diff,last)>=0&&mpfr_cmp(stall,scale)<0;
         //mpc_out_str(stdout,10,0,root,MPC_RNDNN);
         //printf("\n");
     }
@@ -259,19 +641,97 @@ int rootfind_cx(mpz_t *p, int len, mpc_t start,mpc_t root,int log10_thresh, int
     mpc_clear(quot);
     mpc_clear(dummy);
     mpfr_clear(thresh);
-    if(c==max_iterates)
+    mpfr_clear(scale);
+    mpfr_clear(last);
+    mpfr_clear(stall);
+    if(c==max_iterates||(ctl!=NULL&&ctl->expired))
         return 0;
     else
         return 1;
 }
 
 
+//certified radius of a root found by rootfind_cx: some root of p is within rad of root. p(x) has a root within
+//deg*|p(root)/p'(root)| of any x; p and p' are evaluated at 2*PRECISION bits and the bound includes the rounding of
+//that. never less than the last bit of root, which is all its representation holds. see create_basis_cx
+void root_radius_cx(mpz_t *p, int len, mpc_t root, mpfr_t rad, int PRECISION){
+    int i,deg=degree(p,len),wp=2*PRECISION;
+    mpz_t *pp=malloc(len*sizeof(mpz_t)); //p'
+    mpc_t eval; mpc_init2(eval,wp);
+    mpfr_t a; mpfr_init2(a,64); //|root|
+    mpfr_t e; mpfr_init2(e,64); //|p|(|root|), bounds the rounding of the evaluation
+    mpfr_t t; mpfr_init2(t,64);
+
+    for(i=0;i<len;i++)
+        mpz_init(pp[i]);
+    for(i=0;i<len-1;i++)
+        mpz_mul_ui(pp[i],p[i+1],i+1);
+    mpc_abs(a,root,MPFR_RNDU);
+    mpfr_set_ui(e,0,MPFR_RNDU);
+    for(i=len-1;i>=0;i--){
+        mpfr_mul(e,e,a,MPFR_RNDU);
+        mpfr_set_z(t,p[i],MPFR_RNDU);
+        mpfr_abs(t,t,MPFR_RNDU);
+        mpfr_add(e,e,t,MPFR_RNDU);
+    }
+    mpfr_mul_ui(e,e,2*len,MPFR_RNDU);
+    mpfr_mul_2si(e,e,-wp,MPFR_RNDU);
+
+    evaluate_cx(p,len,root,eval,wp);
+    mpc_abs(rad,eval,MPFR_RNDU);
+    mpfr_add(rad,rad,e,MPFR_RNDU);
+    mpfr_mul_ui(rad,rad,MAX(deg,1),MPFR_RNDU);
+    evaluate_cx(pp,len,root,eval,wp);
+    mpc_abs(t,eval,MPFR_RNDD);
+    mpfr_sub(t,t,e,MPFR_RNDD);
+    if(mpfr_sgn(t)>0)
+        mpfr_div(rad,rad,t,MPFR_RNDU);
+    else
+        mpfr_add_ui(rad,a,1,MPFR_RNDU); //p'(root) too close to 0 to tell
+    //last bit of root
+    if(mpfr_zero_p(a))
+        mpfr_set_ui_2exp(t,1,-PRECISION,MPFR_RNDU);
+    else
+        mpfr_set_ui_2exp(t,1,mpfr_get_exp(a)-PRECISION,MPFR_RNDU);
+    mpfr_max(rad,rad,t,MPFR_RNDU);
+
+    for(i=0;i<len;i++)
+        mpz_clear(pp[i]);
+    free(pp);
+    mpc_clear(eval);
+    mpfr_clear(a);
+    mpfr_clear(e);
+    mpfr_clear(t);
+}
+
+//radius of 1/root given that of root (the inverse of the ball, plus the rounding of 1/root). return 0 if the ball contains 0
+int inverse_radius_cx(mpc_t root, mpfr_t rad, mpfr_t rad_inv, int PRECISION){
+    mpfr_t a; mpfr_init2(a,64); //|root|
+    mpfr_t t; mpfr_init2(t,64);
+    int ok;
+
+    mpc_abs(a,root,MPFR_RNDD);
+    mpfr_sub(t,a,rad,MPFR_RNDD);
+    ok=mpfr_sgn(t)>0;
+    if(ok){
+        //|1/x-1/root| <= rad/(|root|(|root|-rad))
+        mpfr_mul(t,t,a,MPFR_RNDD);
+        mpfr_div(rad_inv,rad,t,MPFR_RNDU);
+        mpfr_set_ui_2exp(t,1,2-mpfr_get_exp(a)-PRECISION,MPFR_RNDU); //1/root<2^(2-exp)
+        mpfr_add(rad_inv,rad_inv,t,MPFR_RNDU);
+    }
+    mpfr_clear(a);
+    mpfr_clear(t);
+    return ok;
+}
+
 //divide polynomial p by polynomial d, i.e. compute quotient q in p=d*q+r
-//everything monic
+//if d isn't monic, every quotient coefficient must be divisible by its leading coefficient, i.e. q is required to be
+//in Z[x]. for primitive d that is no restriction: if d divides p in Q[x], it does in Z[x] (Gauss' lemma)
 //each poly should be allocated to 'len' size
-//returns 0 if r=0, 1 otherwise
+//returns 0 if r=0, 1 otherwise (and then out is not the quotient if d isn't monic)
 int polydivide(mpz_t *p,mpz_t *d,mpz_t *out,int len){
-    int i,j,offset,deg_d,return_val;
+    int i,j,offset,deg_d,return_val,exact=1;
     mpz_t dummy;mpz_init(dummy);
 
     //populate out. starts off as reverse(p), becomes [reverse(q),reverse(r)] after division. 
@@ -287,6 +747,14 @@ int polydivide(mpz_t *p,mpz_t *d,mpz_t *out,int len){
     for(i=0;i<offset;i++){
         mpz_set(dummy,out[i]);
         if(mpz_sgn(dummy)!=0){
+            if(mpz_cmp_ui(d[deg_d],1)!=0){ //quotient coefficient is out[i]/lc(d)
+                if(!mpz_divisible_p(dummy,d[deg_d])){
+                    exact=0;
+                    break;
+                }
+                mpz_divexact(dummy,dummy,d[deg_d]);
+                mpz_set(out[i],dummy);
+            }
             for(j=offset;j<len;j++)
                 mpz_submul(out[i+j-offset+1],d[len-j-1],dummy); //out[i+j-offset+1] -= reverse(d)[j]*dummy
         }
@@ -296,7 +764,7 @@ int polydivide(mpz_t *p,mpz_t *d,mpz_t *out,int len){
     i=0;
     while(mpz_sgn(out[len-1-i])==0&&i<=deg_d)
         i++;
-    if(i==deg_d) //if r=0
+    if(exact&&i==deg_d) //if r=0
         return_val=0;
     else
         return_val=1;
@@ -348,6 +816,9 @@ int polydivide_r(mpq_t *p,mpq_t *d,mpq_t *r,int len){
         for(i=0;i<len;i++)
             mpq_clear(outq[i]);
         free(outq);
+        mpq_clear(dummy);
+        mpq_clear(dummy2);
+        mpq_clear(lc);
         return 0; //can always divide by degree zero divisor
         //edge case (if d=0)
     }
@@ -356,6 +827,9 @@ int polydivide_r(mpq_t *p,mpq_t *d,mpq_t *r,int len){
         for(i=0;i<len;i++)
             mpq_clear(outq[i]);
         free(outq);
+        mpq_clear(dummy);
+        mpq_clear(dummy2);
+        mpq_clear(lc);
         return 0; //can't divide by zero
     }
 
@@ -403,11 +877,11 @@ int polydivide_r(mpq_t *p,mpq_t *d,mpq_t *r,int len){
 //this algorithm coerces poly1,poly2 into Q[x] and then does a gcd 
 //algorithm over the field Q. What results is generically a non-integer gcd; this
 //can then be coerced into Z[x] by an appropriate multiple
-//for now, this assumes that the gcd will be monic, based on how it is used in factorize()
-//hence the appropriate multiple is the inverse of the leading coefficient
+//the multiple taken is the primitive part with positive leading coefficient (so a monic gcd comes out as is)
 void gcd(mpz_t *poly1, mpz_t *poly2, mpz_t *gcd, int poly_len){
     int i,count_max=poly_len;
     mpq_t lc; mpq_init(lc);
+    mpz_t den; mpz_init(den);
     mpq_t *a=malloc(poly_len*sizeof(mpq_t));//temporary polynomials
     mpq_t *b=malloc(poly_len*sizeof(mpq_t));
     mpq_t *r=malloc(poly_len*sizeof(mpq_t));
@@ -434,13 +908,21 @@ void gcd(mpz_t *poly1, mpz_t *poly2, mpz_t *gcd, int poly_len){
 
 
     //set gcd to last nonzero remainder
-    //(make monic first)
+    //(make monic first, then clear denominators and take the primitive part)
     int degr=degree_q(b,poly_len);
     mpq_set(lc,b[degr]); //leading coefficient of gcd, to be divided out
-    for(i=0;i<poly_len;i++){// set gcd = b[i]/lc
+    mpz_set_ui(den,1);
+    for(i=0;i<poly_len;i++){// set b = b[i]/lc
         mpq_div(b[i],b[i],lc);
-        mpq_get_num(gcd[i],b[i]);
+        mpz_lcm(den,den,mpq_denref(b[i]));
+    }
+    for(i=0;i<poly_len;i++){
+        mpz_divexact(gcd[i],den,mpq_denref(b[i]));
+        mpz_mul(gcd[i],gcd[i],mpq_numref(b[i]));
     }
+    poly_content(den,gcd,poly_len);
+    for(i=0;i<poly_len;i++)
+        mpz_divexact(gcd[i],gcd[i],den);
 
     //clear variables
     for(i=0;i<poly_len;i++){
@@ -449,6 +931,7 @@ void gcd(mpz_t *poly1, mpz_t *poly2, mpz_t *gcd, int poly_len){
         mpq_clear(r[i]);
     }
     mpq_clear(lc);
+    mpz_clear(den);
     free(a);
     free(b);
     free(r);
@@ -456,17 +939,306 @@ void gcd(mpz_t *poly1, mpz_t *poly2, mpz_t *gcd, int poly_len){
 }
 
 
+//print a progress event as a single line "progress {...}" on stderr, fmt being the body of a json object
+//only does anything if ctx->progress is set. stderr is flushed so that a reading process sees events as they happen
+void progress_event(const factor_ctx *ctx, const char *fmt, ...){
+    va_list args;
+    if(ctx==NULL||!ctx->progress)
+        return;
+    va_start(args,fmt);
+    fprintf(stderr,"progress {");
+    vfprintf(stderr,fmt,args);
+    fprintf(stderr,"}\n");
+    fflush(stderr);
+    va_end(args);
+}
+
+//deadline/cancellation control of ctx (NULL if ctx is NULL)
+lll_control *ctx_control(factor_ctx *ctx){
+    return ctx!=NULL ? &ctx->ctl : NULL;
+}
+
+//start a new profile entry for a find_factor_cx call and point the LLL counters at it. NULL if not profiling
+factor_stats *stats_begin(factor_ctx *ctx, int input_degree){
+    run_stats *rs;
+    factor_stats *fs;
+    if(ctx==NULL||ctx->stats==NULL)
+        return NULL;
+    rs=ctx->stats;
+    if(rs->count==rs->cap){
+        rs->cap=MAX(2*rs->cap,8);
+        rs->factors=realloc(rs->factors,rs->cap*sizeof(factor_stats));
+    }
+    fs=&rs->factors[rs->count++];
+    memset(fs,0,sizeof(factor_stats));
+    fs->input_degree=input_degree;
+    ctx->ctl.stats=&fs->lll_counts;
+    return fs;
+}
+
+//stop counting LLL operations (the entry may move on the next realloc)
+void stats_end(factor_ctx *ctx){
+    if(ctx!=NULL)
+        ctx->ctl.stats=NULL;
+}
+
+void run_stats_clear(run_stats *rs){
+    free(rs->factors);
+    rs->factors=NULL;
+    rs->count=0;
+    rs->cap=0;
+}
+
+//print the profile as a single json object (times in milliseconds)
+void print_stats_json(FILE *f, const run_stats *rs, int PRECISION, double delta, double wall_ms, double cpu_ms){
+    int k;
+    const factor_stats *fs;
+    lll_stats total={0,0,0,0};
+    double root=0,basis=0,lll=0,divide=0;
+
+    fprintf(f,"{\"precision\":%d,\"delta\":%g,\"factors\":[",PRECISION,delta);
+    for(k=0;k<rs->count;k++){
+        fs=&rs->factors[k];
+        fprintf(f,"%s{\"input_degree\":%d,\"factor_degree\":%d,",k>0 ? "," : "",fs->input_degree,fs->factor_degree);
+        fprintf(f,"\"root_ms\":%.3f,\"basis_ms\":%.3f,\"lll_ms\":%.3f,\"divide_ms\":%.3f,",
+                1e3*fs->root,1e3*fs->basis,1e3*fs->lll,1e3*fs->divide);
+        fprintf(f,"\"lll_calls\":%d,\"lll_iterations\":%ld,\"swaps\":%ld,\"size_reductions\":%ld,\"gs_updates\":%ld}",
+                fs->lll_calls,fs->lll_counts.iterations,fs->lll_counts.swaps,fs->lll_counts.size_reductions,fs->lll_counts.gs_updates);
+        root+=fs->root;
+        basis+=fs->basis;
+        lll+=fs->lll;
+        divide+=fs->divide;
+        total.iterations+=fs->lll_counts.iterations;
+        total.swaps+=fs->lll_counts.swaps;
+        total.size_reductions+=fs->lll_counts.size_reductions;
+        total.gs_updates+=fs->lll_counts.gs_updates;
+    }
+    fprintf(f,"],\"totals\":{\"squarefree_ms\":%.3f,\"database_ms\":%.3f,\"root_ms\":%.3f,\"basis_ms\":%.3f,\"lll_ms\":%.3f,\"divide_ms\":%.3f,\"multiplicity_ms\":%.3f,",
+            1e3*rs->squarefree,1e3*rs->database,1e3*root,1e3*basis,1e3*lll,1e3*divide,1e3*rs->multiplicity);
+    fprintf(f,"\"lll_iterations\":%ld,\"swaps\":%ld,\"size_reductions\":%ld,\"gs_updates\":%ld},",
+            total.iterations,total.swaps,total.size_reductions,total.gs_updates);
+    fprintf(f,"\"wall_ms\":%.3f,\"cpu_ms\":%.3f}\n",wall_ms,cpu_ms);
+}
+
+//next 64 bits of the splitmix64 stream r
+uint64_t rng_next(rng64 *r){
+    uint64_t z=(r->state+=0x9e3779b97f4a7c15ULL);
+    z=(z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+    z=(z^(z>>27))*0x94d049bb133111ebULL;
+    return z^(z>>31);
+}
+
+//the stream of r for key (r itself is not advanced, so the same key always gives the same child)
+void rng_split(const rng64 *r, uint64_t key, rng64 *child){
+    rng64 t={r->state^(key*0xd1342543de82ef95ULL)};
+    child->state=rng_next(&t);
+}
+
+//uniform in [0,1), 53 bits
+double rng_uniform(rng64 *r){
+    return (double)(rng_next(r)>>11)*0x1.0p-53;
+}
+
+//hash of the coefficients of p (through their residues mod FACTOR_DB_PRIME), to key the stream of each polynomial
+uint64_t poly_hash(mpz_t *p, int len){
+    int i;
+    rng64 h={(uint64_t)len};
+    for(i=0;i<len;i++){
+        h.state^=mpz_fdiv_ui(p[i],FACTOR_DB_PRIME);
+        rng_next(&h);
+    }
+    return rng_next(&h);
+}
+
+//inverse of a mod prime (extended euclid), 0 if a is 0 mod prime
+uint64_t inverse_mod_p(uint64_t a, uint64_t prime){
+    int64_t t=0,new_t=1,q,tmp;
+    uint64_t r=prime,new_r=a%prime,tmp_r;
+    while(new_r!=0){
+        q=(int64_t)(r/new_r);
+        tmp=t-q*new_t; t=new_t; new_t=tmp;
+        tmp_r=r-(uint64_t)q*new_r; r=new_r; new_r=tmp_r;
+    }
+    if(r!=1)
+        return 0;
+    return t<0 ? (uint64_t)(t+(int64_t)prime) : (uint64_t)t;
+}
+
+//take the residues of poly (of length len) for mod_screen_divides
+void mod_screen_init(mod_screen *s, mpz_t *poly, int len){
+    int i,l;
+    s->deg_p=degree(poly,len);
+    s->p=malloc(3*(s->deg_p+1)*SCREEN_PRIMES*sizeof(uint64_t));
+    s->d=s->p+(s->deg_p+1)*SCREEN_PRIMES;
+    s->work=s->d+(s->deg_p+1)*SCREEN_PRIMES;
+    for(l=0;l<SCREEN_PRIMES;l++){
+        s->inv[l]=UINT64_MAX/screen_primes[l];
+        s->r64[l]=UINT64_MAX%screen_primes[l]+1; //no prime divides 2^64, so this stays below the prime
+    }
+    for(i=0;i<=s->deg_p;i++)
+        screen_residues(s,poly[i],&s->p[i*SCREEN_PRIMES]);
+}
+
+void mod_screen_clear(mod_screen *s){
+    free(s->p);
+    s->p=NULL;
+}
+
+//x mod screen_primes[l], by Barrett reduction: the quotient estimate x*inv/2^64 is at most 2 below the quotient
+uint64_t screen_reduce(const mod_screen *s, uint64_t x, int l){
+    uint64_t q=(uint64_t)(((unsigned __int128)x*s->inv[l])>>64);
+    x-=q*screen_primes[l];
+    while(x>=screen_primes[l])
+        x-=screen_primes[l];
+    return x;
+}
+
+//residues of z mod each screen prime (in [0,prime), also for negative z), from its limbs
+void screen_residues(const mod_screen *s, const mpz_t z, uint64_t *out){
+    int l;
+#if GMP_NUMB_BITS==64
+    long k;
+    for(l=0;l<SCREEN_PRIMES;l++)
+        out[l]=0;
+    for(k=(long)mpz_size(z)-1;k>=0;k--){
+        for(l=0;l<SCREEN_PRIMES;l++)
+            out[l]=screen_reduce(s,out[l]*s->r64[l]+screen_reduce(s,mpz_getlimbn(z,k),l),l);
+    }
+    if(mpz_sgn(z)<0){
+        for(l=0;l<SCREEN_PRIMES;l++)
+            out[l]=out[l]==0 ? 0 : screen_primes[l]-out[l];
+    }
+#else
+    for(l=0;l<SCREEN_PRIMES;l++)
+        out[l]=mpz_fdiv_ui(z,screen_primes[l]);
+#endif
+}
+
+//check if the polynomial d (of length len) divides the polynomial of s modulo each of the screen primes.
+//return 0 if it certainly doesn't divide it, 1 if it may (polydivide still has to confirm)
+//d is made monic mod each prime first; it isn't screened if a prime divides its leading coefficient
+//the remainders are computed without reducing after every multiply: a coefficient only gets reduced when it is
+//divided out (and at the end). each of the at most deg_d updates it receives adds p^2-c*d[j] < 2^54, so it stays
+//below 2^64 up to SCREEN_MAX_DEG. that leaves one reduction per coefficient and prime instead of one per multiply.
+int mod_screen_divides(mod_screen *s, mpz_t *d, int len){
+    int i,j,l,deg_d=degree(d,len),n=(s->deg_p+1)*SCREEN_PRIMES;
+    uint64_t c[SCREEN_PRIMES],sq[SCREEN_PRIMES],lc[SCREEN_PRIMES];
+    uint64_t *w=s->work,*dj;
+
+    if(deg_d>s->deg_p)
+        return 0;
+    if(deg_d<1||deg_d>SCREEN_MAX_DEG)
+        return 1;
+    for(i=0;i<deg_d;i++)
+        screen_residues(s,d[i],&s->d[i*SCREEN_PRIMES]);
+    if(mpz_cmp_ui(d[deg_d],1)!=0){
+        screen_residues(s,d[deg_d],lc);
+        for(l=0;l<SCREEN_PRIMES;l++){
+            lc[l]=inverse_mod_p(lc[l],screen_primes[l]);
+            if(lc[l]==0)
+                return 1;
+        }
+        for(i=0;i<deg_d;i++){
+            for(l=0;l<SCREEN_PRIMES;l++)
+                s->d[i*SCREEN_PRIMES+l]=screen_reduce(s,s->d[i*SCREEN_PRIMES+l]*lc[l],l);
+        }
+    }
+    for(l=0;l<SCREEN_PRIMES;l++)
+        sq[l]=screen_primes[l]*screen_primes[l];
+    memcpy(w,s->p,n*sizeof(uint64_t));
+
+    //synthetic division from the top, in all primes at once
+    for(i=s->deg_p;i>=deg_d;i--){
+        for(l=0;l<SCREEN_PRIMES;l++)
+            c[l]=screen_reduce(s,w[i*SCREEN_PRIMES+l],l);
+        for(j=0;j<deg_d;j++){
+            dj=&s->d[j*SCREEN_PRIMES];
+            for(l=0;l<SCREEN_PRIMES;l++)
+                w[(i-deg_d+j)*SCREEN_PRIMES+l]+=sq[l]-c[l]*dj[l]; //w[i-deg_d+j] -= c*d[j]
+        }
+    }
+    for(i=0;i<deg_d;i++){
+        for(l=0;l<SCREEN_PRIMES;l++){
+            if(screen_reduce(s,w[i*SCREEN_PRIMES+l],l)!=0)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+//accept test for LLL_ctl in find_factor_cx (arg is a divisor_test). return 1 if the basis vector row, read as a
+//polynomial (reversed if t->reversed), has a leading coefficient dividing the polynomial's, nearly vanishes at the root (its root columns are
+//no bigger than the rounding in create_basis_cx explains) and divides the polynomial mod FACTOR_DB_PRIME.
+//cheap next to an LLL iteration; the caller still has to confirm with polydivide
+int divisor_accept(mpz_t *row, int dim, void *arg){
+    divisor_test *t=arg;
+    int i,first=-1,last=-1,bits=0;
+    uint64_t inv;
+    (void)dim;
+
+    for(i=0;i<=t->deg;i++){
+        if(mpz_sgn(row[i])!=0){
+            if(first<0)
+                first=i;
+            last=i;
+            bits=MAX(bits,(int)mpz_sizeinbase(row[i],2));
+        }
+    }
+    if(first<0||last==first||!mpz_divisible_p(t->lc,row[t->reversed ? first : last]))
+        return 0;
+    //each root column is 2^scale*row(root) plus up to (deg+1)*max|coefficient| of error and rounding
+    for(i=t->deg+1;i<t->deg+3;i++){
+        if((int)mpz_sizeinbase(row[i],2)>bits+16)
+            return 0;
+    }
+    //make it monic mod the prime
+    inv=inverse_mod_p(mpz_fdiv_ui(row[t->reversed ? first : last],FACTOR_DB_PRIME),FACTOR_DB_PRIME);
+    if(inv==0)
+        return 0;
+    for(i=first;i<=last;i++)
+        t->d[t->reversed ? last-i : i-first]=(mpz_fdiv_ui(row[i],FACTOR_DB_PRIME)*inv)%FACTOR_DB_PRIME;
+    return divides_mod_p(t->p,t->deg_p,t->d,last-first,FACTOR_DB_PRIME,t->work);
+}
+
+//return 1 if the candidate d (of length len, made primitive) is a factor of poly of positive degree, and set q to the quotient
+int candidate_divides(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len, int len, mod_screen *screen){
+    return (primitive_slide(len,d)>=0)&&degree(d,len)>0&&mpz_divisible_p(poly[poly_len-1],d[degree(d,len)])
+        &&mod_screen_divides(screen,d,len)&&(polydivide(poly,d,q,poly_len)==0);
+}
+
+//bits of precision needed to find a factor of degree deg of poly by LLL, from the height of poly: heights roughly multiply,
+//so such a factor takes about deg/n of the bits of |poly|_2 (n the degree of poly), and a relation on deg+1 powers with
+//coefficients that size needs deg+1 times as many bits, plus HEIGHT_SLACK. deg=n covers an irreducible poly itself
+int height_precision(mpz_t *poly, int poly_len, int deg){
+    int i,n=degree(poly,poly_len);
+    long bits;
+    mpz_t norm; mpz_init(norm); //|poly|_2^2
+
+    for(i=0;i<poly_len;i++)
+        mpz_addmul(norm,poly[i],poly[i]);
+    bits=((long)mpz_sizeinbase(norm,2)+1)/2; //bits of |poly|_2
+    mpz_clear(norm);
+    if(n<1)
+        return HEIGHT_SLACK;
+    return (int)((deg+1)*((deg*bits+n-1)/n))+HEIGHT_SLACK;
+}
+
 //find irreducible factor of poly, poly=d*q. Return zero if no factors found, return 1 if factor is found
 //Warning: this sets d,q to zero upon failure.
 //only finds real roots (for a slight speedup if that's all that is needed)- see below for more general version
 //notes: - might be able to reduce down to at most one dummy variable of each data type
-int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,int verbosity, double d_delta, int stop_deg){
-    int i,j,iter=0,iter_max=3;
-    int sig_digits,deg,input_degree=poly_len-1;
+int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,int verbosity, double d_delta, int stop_deg, factor_ctx *ctx){
+    //the root is found to enough bits for any degree (huge coefficients need more than PRECISION), each lattice is then
+    //built and reduced at the precision its degree needs, but never below PRECISION
+    int base_precision=PRECISION;
+    PRECISION=MAX(PRECISION,height_precision(poly,poly_len,poly_len-1));
+    int i,j,iter=0,iter_max=3,lll_precision;
+    int deg,input_degree=poly_len-1;
     int LLL_found_divisor=0;
     int LLL_hit_cap=0;
     int log10thresh=(int)(PRECISION*log10(2.0)); //closest we can get to root with given PRECISION
-    gmp_randstate_t seed; gmp_randinit_default(seed);//seed for random starting value of rootfind
+    rng64 rng={ctx!=NULL ? ctx->seed : DEFAULT_SEED},attempt; //random starting values of rootfind, keyed by poly
+    rng_split(&rng,poly_hash(poly,poly_len),&rng);
     mpc_t input; mpc_init2(input,PRECISION);
     mpc_t output; mpc_init2(output,PRECISION);
     mpfr_t output_r; mpfr_init2(output_r,PRECISION);
@@ -476,6 +1248,9 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
     mpfr_t dummy; mpfr_init2(dummy,PRECISION); //dummy variables
     mpfr_t dummy2; mpfr_init2(dummy2,PRECISION); //dummy variables 
     mpz_t dummy_z; mpz_init(dummy_z);
+    factor_stats *fs=stats_begin(ctx,input_degree); //NULL if not profiling
+    checkpoint *ck=ctx!=NULL ? ctx->ck : NULL; //NULL if not checkpointing
+    double t0=monotonic_seconds();
 
     //make sure d,q are zeroed out
     for(i=0;i<poly_len;i++){
@@ -489,20 +1264,18 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
 
     //find a root
     mpc_set_d_d(input,0.13,-1.023,MPC_RNDNN); //starting value for rootfind
-    //while rootfind doesn't succeed from specified starting point, pick a new starting point
-    while(!rootfind_cx(poly,poly_len,input,output,log10thresh,PRECISION)&&iter<iter_max){//find root
-        gmp_randseed_ui(seed,rand()); //set random seed
-        mpfr_urandomb(dummy,seed); //real part of starting value in [0,1)
-        mpfr_urandomb(dummy2,seed); //im part of starting value in [0,1)
-        mpfr_mul_si(dummy,dummy,(2*(rand()%2)-1)*2,MPFR_RNDN); //force them to be in (-2,2)
-        mpfr_mul_si(dummy2,dummy2,(2*(rand()%2)-1)*2,MPFR_RNDN);
-        mpc_set_fr_fr(input,dummy,dummy2,MPC_RNDNN); //starting value for rootfind
+    //while rootfind doesn't succeed from specified starting point, pick a new starting point (unless resuming with a saved root)
+    while(!checkpoint_get_root(ck,output)&&!rootfind_cx(poly,poly_len,input,output,log10thresh,PRECISION,ctx_control(ctx))&&iter<iter_max&&!lll_should_stop(ctx_control(ctx))){//find root
+        rng_split(&rng,iter,&attempt); //the same start for this attempt on this poly, however it was reached
+        mpc_set_d_d(input,4*rng_uniform(&attempt)-2,4*rng_uniform(&attempt)-2,MPC_RNDNN); //starting value in (-2,2)^2
         iter++;
     }
-    if(iter==iter_max){//failed to find a root after 50 tries
-        fprintf(stderr,"Failed to find a root.\n");
+    if(fs!=NULL)
+        fs->root=monotonic_seconds()-t0;
+    if(iter==iter_max||lll_should_stop(ctx_control(ctx))){//failed to find a root after 50 tries (or ran out of time)
+        if(!lll_should_stop(ctx_control(ctx)))
+            fprintf(stderr,"Failed to find a root.\n");
         //clear variables and exit
-        gmp_randclear(seed);
         mpc_clear(input);
         mpc_clear(output);
         mpfr_clear(output_r);
@@ -512,9 +1285,12 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
         mpfr_clear(dummy);
         mpfr_clear(dummy2);
         mpz_clear(dummy_z);
+        stats_end(ctx);
         return 0;
     }
 
+    checkpoint_set_root(ck,output);
+    progress_event(ctx,"\"event\":\"root\",\"degree\":%d",input_degree);
     if(verbosity){
         printf("root chosen: ");
         mpc_out_str(stdout,10,0,output,MPC_RNDNN);}
@@ -527,6 +1303,9 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
     mpfr_set_ui(thresh,10,MPFR_RNDN);
     mpfr_pow_ui(thresh,thresh,log10thresh,MPFR_RNDN);
     mpfr_ui_div(thresh,1,thresh,MPFR_RNDN); //set value of thresh from log10thresh
+    mpc_abs(dummy,output,MPC_RNDNN);
+    if(mpfr_cmp_ui(dummy,1)>0)
+        mpfr_mul(thresh,thresh,dummy,MPFR_RNDN); //relative to a large root, as in rootfind_cx
 
     mpfr_round(dummy,output_r); //round real and imaginary parts to integer
     mpfr_round(dummy2,output_i); 
@@ -541,7 +1320,11 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
         mpz_mul_si(d[0],dummy_z,-1); //set d(x) = x-output, since output is integer
         mpz_set_si(d[1],1);
         //check that d is a divisor
-        if(polydivide(poly,d,q,poly_len)==0){
+        t0=monotonic_seconds();
+        i=polydivide(poly,d,q,poly_len);
+        if(fs!=NULL)
+            fs->divide+=monotonic_seconds()-t0;
+        if(i==0){
             if(verbosity){
                 printf("\nFactor found:\n");
                 printf("--> ");
@@ -551,8 +1334,7 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
                 print_poly(poly_len,q,1);
                 printf("\n");}
             //clear variables
-            gmp_randclear(seed);
-            mpc_clear(input);
+                mpc_clear(input);
             mpc_clear(output);
             mpfr_clear(output_r);
             mpfr_clear(output_i);
@@ -561,6 +1343,9 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
             mpfr_clear(dummy);
             mpfr_clear(dummy2);
             mpz_clear(dummy_z);
+            if(fs!=NULL)
+                fs->factor_degree=1;
+            stats_end(ctx);
             return 1;
         }
     }
@@ -571,10 +1356,48 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
     //otherwise run LLL on each degree less than input degree to find minimal polynomial
     mpz_t *basis;//initialize basis
     basis=malloc((input_degree+1)*(input_degree+3)*sizeof(mpz_t));
+    //give every entry room for the scaled root up front, so that LLL rarely has to grow an entry
     for(i=0;i<(input_degree+1)*(input_degree+3);i++)
-        mpz_init(basis[i]);
-
-    for(deg=2;deg<=input_degree;deg++){//loop on degrees
+        mpz_init2(basis[i],PRECISION+GMP_NUMB_BITS);
+
+    //let LLL stop as soon as its first vector looks like a factor (divides poly mod a prime)
+    lll_control local_ctl={0,NULL,0,NULL,NULL,NULL,0,0,0};
+    lll_control *ctl=ctx!=NULL ? ctx_control(ctx) : &local_ctl;
+    int relation=ctx!=NULL ? ctx->relation : RELATION_LLL;
+    mpz_t norm; mpz_init(norm); //ceil of the l2 norm of poly, times 2^deg bounds the norm of a factor of degree deg (Mignotte)
+    mpz_t bound; mpz_init(bound);
+    for(i=0;i<poly_len;i++)
+        mpz_addmul(norm,poly[i],poly[i]);
+    mpz_sqrt(norm,norm);
+    mpz_add_ui(norm,norm,1);
+    divisor_test test;
+    test.deg_p=input_degree;
+    test.lc=poly[input_degree];
+    test.p=malloc(3*(input_degree+1)*sizeof(uint64_t));
+    test.d=test.p+input_degree+1;
+    test.work=test.d+input_degree+1;
+    poly_mod_p(poly,input_degree+1,test.p,FACTOR_DB_PRIME);
+    mod_screen screen; //most candidates don't divide poly, this rejects them without polydivide
+    mod_screen_init(&screen,poly,poly_len);
+    mpc_t inverse; mpc_init2(inverse,PRECISION); //1/root, a root of the reverse of poly
+    mpc_ui_div(inverse,1,output,MPC_RNDNN);
+    mpfr_t rad; mpfr_init2(rad,64); //the exact root is within rad of output
+    mpfr_t rad_inv; mpfr_init2(rad_inv,64); //and its inverse within rad_inv of inverse
+    mpfr_t rad_deg; mpfr_init2(rad_deg,64); //radius of the one used, as if known only to lll_precision bits
+    root_radius_cx(poly,poly_len,output,rad,PRECISION);
+    int invertible=inverse_radius_cx(output,rad,rad_inv,PRECISION);
+    power_table powers; //root^i and (if invertible) root^-i up to the input degree, shared by every degree below
+    power_table powers_inv;
+    power_table_init(&powers,output,input_degree,PRECISION);
+    if(invertible)
+        power_table_init(&powers_inv,inverse,input_degree,PRECISION);
+
+    //a rational root that isn't an integer (only possible if poly isn't monic) is found by LLL in degree 1
+    //if resuming, the degrees searched before on this root are skipped
+    deg=mpz_cmpabs_ui(poly[input_degree],1)==0 ? 2 : 1;
+    if(ck!=NULL)
+        deg=MAX(deg,ck->deg_done+1);
+    for(;deg<=input_degree;deg++){//loop on degrees
 
         // break if cap hit
         if(deg==stop_deg){
@@ -582,20 +1405,75 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
             break; 
         }
 
+        progress_event(ctx,"\"event\":\"lll\",\"degree\":%d",deg);
         if(verbosity){
             printf("      LLL searching for factor of degree %d...",deg);}
-        sig_digits=sig_mpc(output,deg,PRECISION);
-        //find irreducible polynomial for chosen root
-        create_basis_cx(basis,output,deg,sig_digits,PRECISION);
-        LLL(deg+3,deg+1,basis,delta,PRECISION); //use passed PRECISION value
-        //LLL(deg+3,deg+1,basis,delta,(3*PRECISION)/4); //use fraction of passed PRECISION value
-        for(j=0;j<deg+1;j++)
-            mpz_set(d[j],basis[j]); //set first vector of reduced basis to divisor d
-
-        //TODO: pick shortest vector instead of first one
-
-        //synthetic division to check it actually divides and to find both factors
-        if((monic_slide(deg+1,d)>=0)&&(polydivide(poly,d,q,poly_len)==0)){
+        t0=monotonic_seconds();
+        //use the root or its inverse, whichever gives smaller lattice entries. the minimal polynomial of 1/root is the
+        //reverse of the root's, so the vectors then hold the coefficients from x^deg down
+        test.reversed=invertible&&basis_bits_cx(inverse,rad_inv,deg,PRECISION)<basis_bits_cx(output,rad,deg,PRECISION);
+        test.deg=deg;
+        if(relation==RELATION_PSLQ){
+            //no lattice: pslq works on the powers of the root, and gives up once a factor of degree deg is too long
+            mpz_mul_2exp(bound,norm,deg);
+            if(fs!=NULL)
+                fs->lll_calls++;
+            i=pslq_poly_cx(test.reversed ? &powers_inv : &powers,deg,basis,bound,ctl);
+            if(fs!=NULL)
+                fs->lll+=monotonic_seconds()-t0;
+            if(i){
+                for(j=0;j<deg+1;j++)
+                    mpz_set(d[j],basis[test.reversed ? deg-j : j]);
+                t0=monotonic_seconds();
+                i=candidate_divides(poly,d,q,poly_len,deg+1,&screen);
+                if(fs!=NULL)
+                    fs->divide+=monotonic_seconds()-t0;
+            }
+        }
+        else{
+            //a lattice of this degree only needs the root to lll_precision bits
+            lll_precision=MAX(base_precision,height_precision(poly,poly_len,deg));
+            mpc_abs(rad_deg,test.reversed ? inverse : output,MPFR_RNDU);
+            mpfr_mul_2si(rad_deg,rad_deg,-lll_precision,MPFR_RNDU);
+            mpfr_max(rad_deg,rad_deg,test.reversed ? rad_inv : rad,MPFR_RNDU);
+            //find irreducible polynomial for chosen root
+            create_basis_cx(basis,test.reversed ? &powers_inv : &powers,rad_deg,deg);
+            if(fs!=NULL){
+                fs->basis+=monotonic_seconds()-t0;
+                fs->lll_calls++;
+            }
+            ctl->accept=divisor_accept;
+            ctl->accept_arg=&test;
+            ctl->accepted=0;
+            do{
+                t0=monotonic_seconds();
+                i=LLL_ctl(deg+3,deg+1,basis,delta,lll_precision,ctl);
+                if(fs!=NULL)
+                    fs->lll+=monotonic_seconds()-t0;
+                if(!i)
+                    break; //stopped early, basis is useless
+                //LLL(deg+3,deg+1,basis,delta,(3*PRECISION)/4); //use fraction of passed PRECISION value
+                for(j=0;j<deg+1;j++)
+                    mpz_set(d[j],basis[test.reversed ? deg-j : j]); //set first vector of reduced basis to divisor d
+
+                //TODO: pick shortest vector instead of first one
+
+                //synthetic division to check it actually divides and to find both factors
+                t0=monotonic_seconds();
+                i=candidate_divides(poly,d,q,poly_len,deg+1,&screen);
+                if(fs!=NULL)
+                    fs->divide+=monotonic_seconds()-t0;
+                //if LLL stopped on a false positive of the mod p test, finish the reduction and look again
+                if(!i&&ctl->accept!=NULL&&ctl->accepted){
+                    ctl->accept=NULL;
+                    i=-1;
+                }
+            }while(i<0);
+        }
+        ctl->accept=NULL;
+        if(lll_should_stop(ctl))
+            break;
+        if(i){
             LLL_found_divisor=1;
             if(verbosity){
                 printf("\nFactor found:\n");
@@ -609,18 +1487,21 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
         if(verbosity){
             printf(" none\n");
         }
+        checkpoint_degree(ck,deg);
     }
 
     if(!LLL_found_divisor||LLL_hit_cap){
         //no divisor found by LLL, clear variables and exit
-        if(LLL_hit_cap){
+        if(lll_should_stop(ctx_control(ctx))){
+            fprintf(stderr,"Deadline, cancellation or iteration cap reached, stopping.\n");
+        }
+        else if(LLL_hit_cap){
             fprintf(stderr,"Maximum allowed degree %d hit.\n",stop_deg);
         }
         else{
             fprintf(stderr,"No factor found, increase precision or delta parameter.\n");
         }
 
-        gmp_randclear(seed);
         mpc_clear(input);
         mpc_clear(output);
         mpfr_clear(output_r);
@@ -633,11 +1514,22 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
         for(i=0;i<(input_degree+1)*(input_degree+3);i++)
             mpz_clear(basis[i]);
         free(basis);
+        free(test.p);
+        mod_screen_clear(&screen);
+        mpc_clear(inverse);
+        power_table_clear(&powers);
+        if(invertible)
+            power_table_clear(&powers_inv);
+        mpfr_clear(rad);
+        mpfr_clear(rad_inv);
+        mpfr_clear(rad_deg);
+        mpz_clear(norm);
+        mpz_clear(bound);
+        stats_end(ctx);
         return 0;
     }
 
     //clear variables
-    gmp_randclear(seed);
     mpc_clear(input);
     mpc_clear(output);
     mpfr_clear(output_r);
@@ -650,68 +1542,110 @@ int find_factor_cx(mpz_t *poly, mpz_t *d, mpz_t *q, int poly_len,int PRECISION,i
     for(i=0;i<(input_degree+1)*(input_degree+3);i++)
         mpz_clear(basis[i]);
     free(basis);
+    free(test.p);
+    mod_screen_clear(&screen);
+    mpc_clear(inverse);
+    power_table_clear(&powers);
+    if(invertible)
+        power_table_clear(&powers_inv);
+    mpfr_clear(rad);
+    mpfr_clear(rad_inv);
+    mpfr_clear(rad_deg);
+    mpz_clear(norm);
+    mpz_clear(bound);
+    if(fs!=NULL)
+        fs->factor_degree=deg;
+    stats_end(ctx);
     if(verbosity){printf("\n");}
     return 1;
 }
 
-//factorize poly, store factors in mpz_t factors.
-//returns the number of factors (0 if failed, 1 if irreducible, etc)
+//factorize poly (primitive, i.e. without content, see factorize_full), appending its factors to fl (with multiplicity 1).
+//returns the number of factors added (0 if failed, 1 if irreducible, etc)
 //not guaranteed to work if poly has factors of higher multiplicity (due 
 //to Halley's method rounding). Consequently, one should pass poly/gcd(poly,poly')
 //and keep track of the gcd separately
-int factorize(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors,int verbosity, double delta, int stop_deg){
-    int i;
+//if ctx->db is set, its entries are divided out first
+//if ctx->ctl expires, the unfactored quotient is added as the last factor and its index is saved in ctx->cofactor
+//if ctx->ck is set, the progress is saved there (see checkpoint.h), and a loaded checkpoint of poly is resumed
+//all work is done over the current degree of the quotient, not poly_len
+int factorize(mpz_t *poly,int poly_len,int PRECISION,factor_list *fl,int verbosity, double delta, int stop_deg, factor_ctx *ctx){
+    int i,len;
     int is_reducible=1;
     int factor_counter=0;
-    int degree_q=poly_len-1;
+    int first=fl->count; //index of the first factor added here
+    int degree_q;
     mpz_t *d;
     mpz_t *q;
+    checkpoint *ck=ctx!=NULL ? ctx->ck : NULL; //NULL if not checkpointing
 
-    //check if poly is monic (must be)
     int degree_poly=degree(poly,poly_len);
-    if(mpz_cmp_ui(poly[degree_poly],1)!=0){
-        fprintf(stderr,"Polynomial not monic, cannot divide\n");
-        return 0;
-    }
 
-    d=malloc(poly_len*sizeof(mpz_t));//divisor for intermediate step
-    q=malloc(poly_len*sizeof(mpz_t));//quotient for intermediate step
-    for(i=0;i<poly_len;i++){
+    //resuming: start from the saved factors and quotient
+    factor_counter=checkpoint_begin(ck,poly,degree_poly+1,fl);
+    degree_q=degree(poly,degree_poly+1);
+
+    d=malloc((degree_poly+1)*sizeof(mpz_t));//divisor for intermediate step
+    q=malloc((degree_poly+1)*sizeof(mpz_t));//quotient for intermediate step
+    for(i=0;i<=degree_poly;i++){
         mpz_init(d[i]);
         mpz_init(q[i]);
-        mpz_set_ui(d[i],0);
-        mpz_set_ui(q[i],0);
     }
 
+    //divide out known small factors
+    if(ctx!=NULL&&ctx->db!=NULL){
+        double t0=monotonic_seconds();
+        i=factor_db_divide(ctx->db,poly,degree_poly+1,fl,verbosity);
+        if(ctx->stats!=NULL)
+            ctx->stats->database+=monotonic_seconds()-t0;
+        if(i>0){
+            factor_counter+=i;
+            degree_q=degree(poly,degree_poly+1);
+            checkpoint_next(ck);
+            progress_event(ctx,"\"event\":\"factor\",\"found\":%d,\"remaining_degree\":%d",factor_counter,degree_q);
+        }
+    }
 
     while(is_reducible&&degree_q>0){
         //find a factor
-        is_reducible=find_factor_cx(poly,d,q,degree_q+1,PRECISION,verbosity,delta,stop_deg);
-        degree_q=degree(q,poly_len);
+        len=degree_q+1;
+        is_reducible=find_factor_cx(poly,d,q,len,PRECISION,verbosity,delta,stop_deg,ctx);
+        degree_q=degree(q,len);
         //copy factor d to factor bank
         if(is_reducible){
-            for(i=0;i<poly_len;i++)
-                mpz_set(factors[factor_counter*poly_len+i],d[i]);
+            factor_list_add(fl,d,degree(d,len),1);
             factor_counter++;
+            progress_event(ctx,"\"event\":\"factor\",\"found\":%d,\"remaining_degree\":%d",factor_counter,degree_q);
         }
         else{
-            for(i=0;i<poly_len;i++){
+            //whichever way it stopped, keep what we have so that it can be resumed
+            checkpoint_save(ck);
+            //out of time: return what we have, with the rest as the cofactor
+            if(lll_should_stop(ctx_control(ctx))){
+                ctx->cofactor=factor_list_add(fl,poly,degree(poly,len),1);
+                factor_counter++;
+            }
+            else{
+                factor_list_truncate(fl,first);
+                factor_counter=0;
+            }
+            for(i=0;i<=degree_poly;i++){
                 mpz_clear(d[i]);
                 mpz_clear(q[i]);
             }
             free(d);
             free(q);
-            return 0;
+            return factor_counter;
         }
-        //zero out d (not sure why this is necessary, since it is done in find_factor_cx)
-        for(i=0;i<poly_len;i++){mpz_set_ui(d[i],0);}
         //set poly to quotient by factor
-        for(i=0;i<poly_len;i++)
+        for(i=0;i<len;i++)
             mpz_set(poly[i],q[i]);
+        checkpoint_next(ck);
+        checkpoint_tick(ck);
     }
 
     //clear variables
-    for(i=0;i<poly_len;i++){
+    for(i=0;i<=degree_poly;i++){
         mpz_clear(d[i]);
         mpz_clear(q[i]);
     }
@@ -725,19 +1659,26 @@ int factorize(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors,int verbosit
 //essentially calls factorize() on poly/gcd(poly,poly') and gcd(poly,poly')
 //iteratively, to mitigate factoring polynomials with repeated factors
 //If p = f_1^{n_1} * ... * f_k^{n_k}, then this first finds f_1,...,f_k then n_1,...,n_k
-//the f_i are stored in factors and the n_i are stored in multiplicities
+//the f_i and n_i are appended to fl. returns the number of factors added (0 if failed)
+//the f_i are primitive with positive leading coefficient; the content of p (the gcd of its coefficients, with
+//the sign of its leading coefficient) is added last as a factor of degree 0 if it isn't 1
 //finds the largest degree, square free factor. Factors that and then find the multiplicities of those factors
-int factorize_full(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors, int *multiplicities,int verbosity, double delta, int stop_deg){
-    int i,j,mult,new_factors=0;
-
-    //if it is degree 1 or less: we are done
-    if(degree(poly,poly_len)<=1){
-        for(i=0;i<poly_len;i++)
-            mpz_set(factors[i],poly[i]);
+int factorize_full(mpz_t *poly,int poly_len,int PRECISION,factor_list *fl,int verbosity, double delta, int stop_deg, factor_ctx *ctx){
+    int i,j,len,mult,new_factors=0;
+    int first=fl->count; //index of the first factor added here
+    int deg=degree(poly,poly_len);
+    mpz_t content; mpz_init(content);
+    poly_content(content,poly,poly_len);
+
+    //if it is degree 1 or less and primitive: we are done
+    if(deg<=0||(deg==1&&mpz_cmp_ui(content,1)==0)){
+        factor_list_add(fl,poly,MAX(deg,0),1);
+        mpz_clear(content);
         return 1;
     }
 
-    //allocate auxillary polynomials used
+    //allocate auxillary polynomials used (of the length of poly without its trailing zeros)
+    poly_len=deg+1;
     mpz_t *p=malloc(poly_len*sizeof(mpz_t));
     mpz_t *pp=malloc(poly_len*sizeof(mpz_t));
     mpz_t *gcd_p=malloc(poly_len*sizeof(mpz_t));
@@ -751,20 +1692,24 @@ int factorize_full(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors, int *m
         mpz_set(p[i],poly[i]);
     }
 
-    //check that it is monic and divide out by highest power of x dividing it
-    int trivial_power=monic_slide_dont_multiply(poly_len,p);
-    if(trivial_power<0){
-        fprintf(stderr,"Polynomial not monic. Unable to divide.\n");
-        return 0;
+    //divide out the content and the highest power of x dividing it
+    int trivial_power=primitive_slide(poly_len,p);
+    if(verbosity && mpz_cmp_ui(content,1)!=0){
+        printf("Content: ");
+        mpz_out_str(stdout,10,content);
+        printf("\n\n");
     }
-    else if(verbosity && trivial_power>0){
+    if(verbosity && trivial_power>0){
         printf("Trivial factor found:\n");
         printf("x^%d\n\n",trivial_power);
     }
 
     //compute gcd of p and p'
-    derivative(p,pp,poly_len);
-    gcd(p,pp,gcd_p,poly_len);
+    double t0=monotonic_seconds();
+    if(degree(p,poly_len)>0){ //(gcd_p stays 0 otherwise)
+        derivative(p,pp,poly_len);
+        gcd(p,pp,gcd_p,poly_len);
+    }
 
     int gcd_deg=degree(gcd_p,poly_len);
     if(gcd_deg>0){//if higher multiplicity factors exist (p is not square-free)
@@ -780,6 +1725,7 @@ int factorize_full(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors, int *m
             free(pp);
             free(gcd_p);
             free(stripped);
+            mpz_clear(content);
 
             return 0;
         }
@@ -790,9 +1736,11 @@ int factorize_full(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors, int *m
         for(i=0;i<poly_len;i++)
             mpz_set(p[i],stripped[i]);
     }
+    if(ctx!=NULL&&ctx->stats!=NULL)
+        ctx->stats->squarefree+=monotonic_seconds()-t0;
 
     if(degree(p,poly_len)>0){//factor square-free part
-        new_factors=factorize(p,poly_len,PRECISION,&factors[0],verbosity,delta,stop_deg);
+        new_factors=factorize(p,poly_len,PRECISION,fl,verbosity,delta,stop_deg,ctx);
         if(new_factors==0){
             for(i=0;i<poly_len;i++){
                 mpz_clear(p[i]);
@@ -804,51 +1752,84 @@ int factorize_full(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors, int *m
             free(pp);
             free(gcd_p);
             free(stripped);
+            mpz_clear(content);
 
             return 0;
         }
     }
 
-    //ensure multiplicities are all zero to start
-    for(i=0;i<poly_len;i++)
-        multiplicities[i]=0;
-
 
-    //compute multiplicites of each factor
+    //compute multiplicites of each factor, working over the degree of the gcd
+    t0=monotonic_seconds();
     if(gcd_deg>0){
         if(verbosity){printf("Counting multiplicities:\n");}
-        for(j=0;j<new_factors;j++){
-            //set p back to original polynomial
-            for(i=0;i<poly_len;i++)
-                mpz_set(p[i],gcd_p[i]);
+        len=gcd_deg+1;
+        for(j=first;j<first+new_factors;j++){
             mult=1;
+            //a factor of higher degree than the gcd is not repeated
+            if(fl->degree[j]<=gcd_deg){
+                //set p back to the gcd, pp to the jth factor
+                for(i=0;i<len;i++){
+                    mpz_set(p[i],gcd_p[i]);
+                    if(i<=fl->degree[j])
+                        mpz_set(pp[i],factor_coefs(fl,j)[i]);
+                    else
+                        mpz_set_ui(pp[i],0);
+                }
 
-            //set pp to be the jth factor
-            for(i=0;i<poly_len;i++)
-                mpz_set(pp[i],factors[j*poly_len+i]);
-
-            //divide by pp until you can't
-            while(polydivide(p,pp,stripped,poly_len)==0){
-                mult++;
-                for(i=0;i<poly_len;i++)
-                    mpz_set(p[i],stripped[i]);
-
+                //divide by pp until you can't
+                while(degree(p,len)>=fl->degree[j]&&polydivide(p,pp,stripped,len)==0){
+                    mult++;
+                    for(i=0;i<len;i++)
+                        mpz_set(p[i],stripped[i]);
+                }
             }
-            multiplicities[j]=mult;
+            fl->multiplicity[j]=mult;
             if(verbosity){
                 printf("factor: ");
-                print_poly(poly_len,pp,0);
+                print_poly(fl->degree[j]+1,factor_coefs(fl,j),0);
                 printf("\nmultiplicity: %d\n",mult);
             }
         }
     }
+    if(ctx!=NULL&&ctx->stats!=NULL)
+        ctx->stats->multiplicity+=monotonic_seconds()-t0;
+
+    //stopped early: the cofactor becomes whatever the factors found don't account for (including repeated parts)
+    if(ctx!=NULL&&ctx->cofactor>=0){
+        for(i=0;i<poly_len;i++)
+            mpz_set(p[i],poly[i]);
+        primitive_slide(poly_len,p);
+        for(j=first;j<first+new_factors;j++){
+            if(j==ctx->cofactor)
+                continue;
+            for(i=0;i<poly_len;i++){
+                if(i<=fl->degree[j])
+                    mpz_set(pp[i],factor_coefs(fl,j)[i]);
+                else
+                    mpz_set_ui(pp[i],0);
+            }
+            for(mult=0;mult<fl->multiplicity[j];mult++){
+                polydivide(p,pp,stripped,poly_len);
+                for(i=0;i<poly_len;i++)
+                    mpz_set(p[i],stripped[i]);
+            }
+        }
+        factor_list_set(fl,ctx->cofactor,p,degree(p,poly_len));
+        fl->multiplicity[ctx->cofactor]=1;
+    }
 
     //add x^i to list of factors 
     if(trivial_power>0){
-        for(i=0;i<poly_len;i++)
-            mpz_set_ui(factors[new_factors*poly_len+i],0);
-        mpz_set_ui(factors[new_factors*poly_len+trivial_power],1);
-        multiplicities[new_factors]=1;
+        for(i=0;i<=trivial_power;i++)
+            mpz_set_ui(pp[i],i==trivial_power);
+        factor_list_add(fl,pp,trivial_power,1);
+        new_factors++;
+    }
+
+    //and the content
+    if(mpz_cmp_ui(content,1)!=0){
+        factor_list_add(fl,&content,0,1);
         new_factors++;
     }
 
@@ -863,67 +1844,38 @@ int factorize_full(mpz_t *poly,int poly_len,int PRECISION,mpz_t *factors, int *m
     free(pp);
     free(gcd_p);
     free(stripped);
+    mpz_clear(content);
 
     return new_factors;
 }
 
 
 
-//make sure p is monic and divide out by highest power of x dividing p
-//if the leading coefficient is -1, multiply through by -1 and proceed
-//return highest power of x dividing p, -1 if not monic
-int monic_slide(int len, mpz_t *p){
-    int first_nz=0;
-    int last_nz=len-1;
+//set c to the content of p: the gcd of its coefficients, with the sign of its leading coefficient (0 if p=0)
+void poly_content(mpz_t c, mpz_t *p, int len){
     int i;
-
-    for(i=0;i<len;i++){
-        if(mpz_sgn(p[i])!=0){
-            first_nz=i;
-            break;
-        }
-    }
-    for(i=len-1;i>=0;i--){
-        if(mpz_sgn(p[i])!=0){
-            last_nz=i;
-            break;
-        }
-    }
-    //divide out by highest power of x dividing p
-    for(i=first_nz;i<len;i++)
-        mpz_set(p[i-first_nz],p[i]);
-    for(i=last_nz-first_nz+1;i<len;i++)
-        mpz_set_ui(p[i],0);
-
-    //monic check - if the leading term is -1, multiply through by -1 to make monic
-    //				if not unit, return 0
-    if(mpz_cmp_si(p[last_nz-first_nz],-1)==0){
-        for(i=0;i<last_nz-first_nz+1;i++)
-            mpz_mul_si(p[i],p[i],-1);
-    }
-    else if(mpz_cmp_si(p[last_nz-first_nz],1)!=0) 
-        return -1;
-
-    return first_nz;
+    mpz_set_ui(c,0);
+    for(i=0;i<len&&mpz_cmp_ui(c,1)!=0;i++)
+        mpz_gcd(c,c,p[i]);
+    i=degree(p,len);
+    if(i>=0&&mpz_sgn(p[i])<0)
+        mpz_neg(c,c);
 }
 
-//same as above, except doesn't multiply through by -1 if that is the leading coef
-int monic_slide_dont_multiply(int len, mpz_t *p){
-    int first_nz=0;
-    int last_nz=len-1;
+//divide p by its content and by the highest power of x dividing it, so that it is primitive with positive
+//leading coefficient (e.g. -2x^3+4x^2 -> x-2)
+//return highest power of x dividing p, -1 if p=0
+int primitive_slide(int len, mpz_t *p){
+    int first_nz=-1;
+    int last_nz=degree(p,len);
     int i;
+    mpz_t c;
 
-    for(i=0;i<len;i++){
-        if(mpz_sgn(p[i])!=0){
+    if(last_nz<0)
+        return -1;
+    for(i=0;i<len&&first_nz<0;i++){
+        if(mpz_sgn(p[i])!=0)
             first_nz=i;
-            break;
-        }
-    }
-    for(i=len-1;i>=0;i--){
-        if(mpz_sgn(p[i])!=0){
-            last_nz=i;
-            break;
-        }
     }
     //divide out by highest power of x dividing p
     for(i=first_nz;i<len;i++)
@@ -931,9 +1883,14 @@ int monic_slide_dont_multiply(int len, mpz_t *p){
     for(i=last_nz-first_nz+1;i<len;i++)
         mpz_set_ui(p[i],0);
 
-    if(mpz_cmp_si(p[last_nz-first_nz],1)!=0) 
-        return -1;
-
+    //and by the content
+    mpz_init(c);
+    poly_content(c,p,last_nz-first_nz+1);
+    if(mpz_cmp_ui(c,1)!=0){
+        for(i=0;i<=last_nz-first_nz;i++)
+            mpz_divexact(p[i],p[i],c);
+    }
+    mpz_clear(c);
     return first_nz;
 }
 
@@ -23,10 +23,45 @@
 #include <mpc.h>
 #include <mpfr.h>
 #include <math.h>
+#include <time.h>
+#include <signal.h>
 
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define STR_MAX 8192 //Maximum string size for alpha. Pretty generous. Be sure this is the same in all files that reference this one. Only used in sig(), which has been replaced by sig_mpf().
+#define LLL_CHECK_EVERY 8 //LLL loop iterations between two checks of lll_control
+#define DD_PRECISION 106 //PRECISION up to which LLL uses double-double (see lll_fp.h)
+#define QD_PRECISION 212 //PRECISION up to which LLL uses quad-double. above, or with LLL_MPF_ONLY defined, mpf
+
+//counters for LLL_ctl (accumulated, never reset by LLL itself)
+typedef struct {
+    long iterations; //passes through the main loop
+    long swaps; //Lovasz condition failures
+    long size_reductions; //basis[k] -= round(mu)*basis[j] updates
+    long gs_updates; //calls to gram_schmidt
+} lll_stats;
+
+//cooperative cancellation for LLL and root finding. a NULL lll_control never stops anything.
+//max_iterations stops at the same point on every run, unlike the deadline
+typedef struct {
+    double deadline; //stop once monotonic clock (seconds) passes this. 0 for no deadline
+    volatile sig_atomic_t *cancel; //stop once *cancel is nonzero (e.g. set by a signal handler). NULL if unused
+    int expired; //set once either of the above happened; stays set
+    lll_stats *stats; //if not NULL, LLL_ctl adds its counts here
+    int (*accept)(mpz_t *row, int dim, void *arg); //if not NULL, LLL_ctl stops as soon as this returns 1 on basis[0]
+    void *accept_arg; //passed to accept
+    int accepted; //set when accept stopped LLL_ctl (reset by the caller)
+    long max_iterations; //stop once LLL has run this many iterations under this control (counted every LLL_CHECK_EVERY). 0 for no cap
+    long iterations; //LLL iterations counted so far
+} lll_control;
+
+//alpha^0,...,alpha^n at PRECISION bits, filled once by repeated multiplication (power_table_init) and then shared by
+//every lattice (create_basis_cx) and relation search (pslq_poly_cx) on alpha, whatever their degree
+typedef struct {
+    int n; //highest power
+    int PRECISION;
+    mpc_t *pow; //pow[i]=alpha^i
+} power_table;
 
 
 void Mpf_round(mpz_t rop, const mpf_t op, int PRECISION);
@@ -43,11 +78,53 @@ void sq_norm(mpf_t *x, int len, mpf_t norm, int PRECISION);
 void sq_norm_z(mpz_t *x, int len, mpz_t norm);
 int sig(char inputStr[STR_MAX],int deg);
 int sig_mpf(mpf_t alpha,int deg,int PRECISION); //
-int sig_mpc(mpc_t alpha,int deg,int PRECISION);
+void power_bounds_cx(mpc_t alpha, mpfr_t rad, int deg, int PRECISION, mpfr_t err, mpfr_t mag);
+long basis_scale_cx(mpc_t alpha, mpfr_t rad, int deg, int PRECISION);
+long basis_bits_cx(mpc_t alpha, mpfr_t rad, int deg, int PRECISION);
+long create_basis_cx(mpz_t *mat, const power_table *pt, mpfr_t rad, int deg);
+void power_table_init(power_table *pt, mpc_t alpha, int n, int PRECISION);
+void power_table_clear(power_table *pt);
 void gram_schmidt(int start,int dim, int nvec, mpz_t *basis, mpf_t *obasis, int PRECISION);
 void gram_coef(int dim,int k,int j, mpz_t *basis, mpf_t *obasis, mpf_t g_coef, int PRECISION);
 void LLL(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION);
+int LLL_ctl(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION, lll_control *ctl);
+int LLL_mpf(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION, lll_control *ctl, lll_stats *stats);
+double monotonic_seconds(void);
+void lll_set_timeout(lll_control *ctl, long msec);
+int lll_should_stop(lll_control *ctl);
+int lll_should_stop_after(lll_control *ctl, int n);
+int lll_accept(lll_control *ctl, mpz_t *basis, int dim);
 int shortest_vec(int dim, int nvec, mpz_t *basis);
+mpf_t *mpf_array_init(int count, int PRECISION);
+void mpf_array_clear(mpf_t *arr, int count);
+
+int lll_block_size=0; //segment size of the segment LLL (see LLL_segment in lll_fp.h), 0 for plain LLL
+
+//fixed precision LLL backends: dd_LLL (double-double) and qd_LLL (quad-double)
+#ifndef LLL_MPF_ONLY
+#define FP dd
+#define FP_N 2
+#include "lll_fp.h"
+#define FP qd
+#define FP_N 4
+#include "lll_fp.h"
+#if LLL_FP_X86
+//the same compiled for AVX2+FMA (dd_avx2_LLL, qd_avx2_LLL), used when the cpu has them (lll_fp_simd)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define FP dd_avx2
+#define FP_N 2
+#define FP_FMA 1
+#include "lll_fp.h"
+#define FP qd_avx2
+#define FP_N 4
+#define FP_FMA 1
+#include "lll_fp.h"
+#pragma GCC pop_options
+#endif
+#endif
+
+#include "pslq.h" //integer relations by PSLQ, the alternative to LLL on the lattice of powers
 
 //variables used throughout:
 //PRECISION: working precision level for all floats in bits.
@@ -174,52 +251,121 @@ void create_basis(mpz_t *mat,mpf_t alpha,int deg,int sig_digits, int PRECISION){
     mpf_clear(alpha_power);
 }
 
-//same as above, execpt alpha is complex (adding extra column for imaginary part)
+//same as above, execpt alpha is complex (adding extra column for imaginary part), and its powers come from pt (deg<=pt->n)
+//alpha is only known to within rad (see root_radius_cx), so instead of 10^sig_digits the powers are scaled by 2^scale,
+//scale=basis_scale_cx(alpha,rad,deg,PRECISION): the largest power of 2 that keeps their certified error below 1.
+//every entry is then correct up to its rounding, and no bigger than it needs to be. returns scale
 //make sure mat is allocated the extra column, i.e. has dimension (deg+1)x(deg+3)
-void create_basis_cx(mpz_t *mat,mpc_t alpha,int deg,int sig_digits, int PRECISION){
+long create_basis_cx(mpz_t *mat, const power_table *pt, mpfr_t rad, int deg){
     int i,j;
-    mpfr_t ten_power; //10^sig_digits
-    mpc_t alpha_power; //alpha^i*ten_power
-    mpfr_t alpha_r; //real part of alpha^i*ten_power
-    mpfr_t alpha_i; //im part of alpha^i*ten_power
-    mpz_t alpha_round_r; // alpha^i*ten_power rounded to int (real part)
-    mpz_t alpha_round_i; // alpha^i*ten_power rounded to int (im. part)
+    long scale=basis_scale_cx(pt->pow[1],rad,deg,pt->PRECISION);
+    mpfr_t alpha_r; //real part of alpha^i*2^scale
+    mpfr_t alpha_i; //im part of alpha^i*2^scale
 
     for(i=0;i<deg+1;i++){
         for(j=0;j<deg+3;j++)
             mpz_set_ui(mat[i*(deg+3)+j],0);
     }
 
-    mpc_init2(alpha_power,PRECISION);
-
-    mpfr_init2(ten_power,PRECISION);
-    mpfr_set_ui(ten_power,10,MPFR_RNDN);
-    mpfr_pow_ui(ten_power,ten_power,sig_digits,MPFR_RNDN);
-
-    mpfr_init2(alpha_r,PRECISION);
-    mpfr_init2(alpha_i,PRECISION);
-    mpz_init(alpha_round_r);
-    mpz_init(alpha_round_i);
+    mpfr_init2(alpha_r,pt->PRECISION);
+    mpfr_init2(alpha_i,pt->PRECISION);
 
     for(i=0;i<deg+1;i++){
-        mpc_pow_ui(alpha_power,alpha,i,MPC_RNDNN);//compute alpha^i
-        mpc_mul_fr(alpha_power,alpha_power,ten_power,MPC_RNDNN);//compute alpha^i*10^sig_digits
-        mpc_real(alpha_r,alpha_power,MPC_RNDNN); //get real and imag parts
-        mpc_imag(alpha_i,alpha_power,MPC_RNDNN);
-        mpfr_get_z(alpha_round_r,alpha_r,MPFR_RNDN); //round them
-        mpfr_get_z(alpha_round_i,alpha_i,MPFR_RNDN); //round them
-        mpz_set(mat[i*(deg+3)+deg+1],alpha_round_r);  //set them to mat[i][deg+1], mat[i][deg+2]
-        mpz_set(mat[i*(deg+3)+deg+2],alpha_round_i); 
-
+        mpfr_mul_2si(alpha_r,mpc_realref(pt->pow[i]),scale,MPFR_RNDN); //exact
+        mpfr_mul_2si(alpha_i,mpc_imagref(pt->pow[i]),scale,MPFR_RNDN);
+        mpfr_get_z(mat[i*(deg+3)+deg+1],alpha_r,MPFR_RNDN); //round them to mat[i][deg+1], mat[i][deg+2]
+        mpfr_get_z(mat[i*(deg+3)+deg+2],alpha_i,MPFR_RNDN);
         mpz_set_ui(mat[i*(deg+3)+i],1); //set mat[i][i] to 1
     }
 
-    mpc_clear(alpha_power);
-    mpfr_clear(ten_power);
     mpfr_clear(alpha_r);
     mpfr_clear(alpha_i);
-    mpz_clear(alpha_round_r);
-    mpz_clear(alpha_round_i);
+    return scale;
+}
+
+//fill pt with alpha^0,...,alpha^n (n>=1) by repeated multiplication, as power_bounds_cx assumes
+void power_table_init(power_table *pt, mpc_t alpha, int n, int PRECISION){
+    int i;
+    pt->n=n;
+    pt->PRECISION=PRECISION;
+    pt->pow=malloc((n+1)*sizeof(mpc_t));
+    for(i=0;i<=n;i++)
+        mpc_init2(pt->pow[i],PRECISION);
+    mpc_set_ui(pt->pow[0],1,MPC_RNDNN);
+    mpc_set(pt->pow[1],alpha,MPC_RNDNN);
+    for(i=2;i<=n;i++)
+        mpc_mul(pt->pow[i],pt->pow[i-1],alpha,MPC_RNDNN);
+}
+
+void power_table_clear(power_table *pt){
+    int i;
+    for(i=0;i<=pt->n;i++)
+        mpc_clear(pt->pow[i]);
+    free(pt->pow);
+}
+
+//ball arithmetic on the powers of alpha, given that the exact root is within rad of it: err bounds the distance of
+//alpha^i (i<=deg), computed by repeated multiplication at PRECISION bits, from the exact root's power, and mag bounds
+//|alpha^i|. (m+e)(|alpha|+rad)-m|alpha| = e(|alpha|+rad)+m*rad, plus the rounding of each product (2^(1-PRECISION)*m)
+void power_bounds_cx(mpc_t alpha, mpfr_t rad, int deg, int PRECISION, mpfr_t err, mpfr_t mag){
+    int i;
+    mpfr_t a; mpfr_init2(a,64); //|alpha|
+    mpfr_t m; mpfr_init2(m,64); //|alpha^i|
+    mpfr_t e; mpfr_init2(e,64); //error of alpha^i
+    mpfr_t t; mpfr_init2(t,64);
+
+    mpc_abs(a,alpha,MPFR_RNDU);
+    mpfr_set_ui(m,1,MPFR_RNDU);
+    mpfr_set_ui(e,0,MPFR_RNDU);
+    mpfr_set_ui(err,0,MPFR_RNDU);
+    mpfr_set_ui(mag,1,MPFR_RNDU);
+    for(i=1;i<=deg;i++){
+        mpfr_add(t,a,rad,MPFR_RNDU);
+        mpfr_mul(e,e,t,MPFR_RNDU);
+        mpfr_mul(t,m,rad,MPFR_RNDU);
+        mpfr_add(e,e,t,MPFR_RNDU);
+        mpfr_mul(m,m,a,MPFR_RNDU);
+        mpfr_mul_2si(t,m,1-PRECISION,MPFR_RNDU);
+        mpfr_add(e,e,t,MPFR_RNDU);
+        mpfr_max(err,err,e,MPFR_RNDU);
+        mpfr_max(mag,mag,m,MPFR_RNDU);
+    }
+
+    mpfr_clear(a);
+    mpfr_clear(m);
+    mpfr_clear(e);
+    mpfr_clear(t);
+}
+
+//exponent of the power of 2 that create_basis_cx scales alpha^i by: the largest that keeps the error bound of
+//power_bounds_cx below 1
+long basis_scale_cx(mpc_t alpha, mpfr_t rad, int deg, int PRECISION){
+    long scale;
+    mpfr_t err; mpfr_init2(err,64);
+    mpfr_t mag; mpfr_init2(mag,64);
+
+    power_bounds_cx(alpha,rad,deg,PRECISION,err,mag);
+    if(mpfr_zero_p(err)) //deg=0
+        scale=PRECISION;
+    else
+        scale=-(long)mpfr_get_exp(err); //err<2^exp
+    mpfr_clear(err);
+    mpfr_clear(mag);
+    return scale;
+}
+
+//bits of the largest root column entry of create_basis_cx(alpha,rad,deg). a root and its inverse can be compared with
+//this, see find_factor_cx
+long basis_bits_cx(mpc_t alpha, mpfr_t rad, int deg, int PRECISION){
+    long bits;
+    mpfr_t err; mpfr_init2(err,64);
+    mpfr_t mag; mpfr_init2(mag,64);
+
+    power_bounds_cx(alpha,rad,deg,PRECISION,err,mag);
+    bits=(long)mpfr_get_exp(mag)+basis_scale_cx(alpha,rad,deg,PRECISION);
+    mpfr_clear(err);
+    mpfr_clear(mag);
+    return bits;
 }
 
 
@@ -424,32 +570,12 @@ int sig_mpf(mpf_t alpha,int deg,int PRECISION){
 }
 
 
-//same as sig_mpf except with complex alpha.
-int sig_mpc(mpc_t alpha,int deg,int PRECISION){
-    int sig_digits=0;
-    mpfr_t norm;mpfr_init2(norm,PRECISION);
-    mpc_abs(norm,alpha,MPC_RNDNN);
-    if(mpfr_cmp_ui(norm,1)<0){//if |alpha|<1
-        mpfr_log10(norm,norm,MPFR_RNDN);
-        sig_digits=sig_digits+(deg+1)*labs(mpfr_get_si(norm,MPFR_RNDU));
-    }
-    sig_digits=sig_digits+(int)(PRECISION*log10(2.0));
-    mpfr_clear(norm);
-    return sig_digits-1;
-}
-
-
-
 //gram schmidt reduce ``basis" (save as ``obasis"). Do not normalize.
 //both must be dim by nvec sized arrays
 //probably not numerically stable. Householders are better for stability, but not sure if that will affect the LLL stage
 void gram_schmidt(int start,int dim, int nvec, mpz_t *basis, mpf_t *obasis, int PRECISION){
-    int i,j,k,s;	
-    mpf_t *dummy;
-    dummy=malloc(dim*sizeof(mpf_t));
-
-    for(i=0;i<dim;i++)
-        mpf_init2(dummy[i],PRECISION);
+    int j,k,s;	
+    mpf_t *dummy=mpf_array_init(dim,PRECISION);
 
     for(k=start;k<nvec;k++){
         //start obasis[k] out as as basis[k]
@@ -464,9 +590,7 @@ void gram_schmidt(int start,int dim, int nvec, mpz_t *basis, mpf_t *obasis, int
         }
     }
     //F R E E  H I M
-    for(i=0;i<dim;i++)
-        mpf_clear(dummy[i]);
-    free(dummy);
+    mpf_array_clear(dummy,dim);
 }
 
 //calculate the (k,j) gram coefficient of the basis
@@ -493,19 +617,100 @@ void gram_coef(int dim,int k,int j, mpz_t *basis, mpf_t *obasis, mpf_t g_coef, i
 }
 
 
+//current time in seconds (monotonic clock)
+double monotonic_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+1e-9*ts.tv_nsec;
+}
+
+//set a deadline msec milliseconds from now (msec<=0 removes it)
+void lll_set_timeout(lll_control *ctl, long msec){
+    ctl->deadline=msec>0 ? monotonic_seconds()+msec/1000.0 : 0;
+}
+
+//return 1 if the computation controlled by ctl should stop (deadline passed, cancelled or out of iterations)
+int lll_should_stop(lll_control *ctl){
+    if(ctl==NULL)
+        return 0;
+    if(!ctl->expired){
+        if(ctl->cancel!=NULL&&*ctl->cancel)
+            ctl->expired=1;
+        else if(ctl->max_iterations>0&&ctl->iterations>=ctl->max_iterations)
+            ctl->expired=1;
+        else if(ctl->deadline>0&&monotonic_seconds()>=ctl->deadline)
+            ctl->expired=1;
+    }
+    return ctl->expired;
+}
+
+//count n more LLL iterations against ctl->max_iterations, then check ctl as above
+int lll_should_stop_after(lll_control *ctl, int n){
+    if(ctl!=NULL)
+        ctl->iterations+=n;
+    return lll_should_stop(ctl);
+}
+
+//return 1 if ctl has an accept test and the first vector of basis passes it (ctl->accepted is then set)
+int lll_accept(lll_control *ctl, mpz_t *basis, int dim){
+    if(ctl==NULL||ctl->accept==NULL)
+        return 0;
+    if(!ctl->accepted&&ctl->accept(basis,dim,ctl->accept_arg))
+        ctl->accepted=1;
+    return ctl->accepted;
+}
+
 //perform LLL reduction on basis
 //uses standard version of LLL, no improvements as of yet. 
 void LLL(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION){
-    int i,j,k,s;
+    LLL_ctl(dim,nvec,basis,delta,PRECISION,NULL);
+}
+
+//same as above, but checks ctl every LLL_CHECK_EVERY iterations and stops early if needed (and counts into ctl->stats)
+//returns 1 if the basis was fully reduced, 0 if stopped early (basis is then only partially reduced).
+//with ctl->accept, the first vector is tested at the same points and LLL_ctl also stops (returning 1, with
+//ctl->accepted set) once it passes, usually long before the rest of the basis is reduced
+//the gram schmidt data is kept in double-double or quad-double when PRECISION allows it, in mpf otherwise
+int LLL_ctl(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION, lll_control *ctl){
+    lll_stats stats={0,0,0,0};
+    int done;
+
+#ifndef LLL_MPF_ONLY
+#if LLL_FP_X86
+    if(PRECISION<=DD_PRECISION&&lll_fp_simd()&&lll_fp_fits(dim*nvec,basis))
+        done=dd_avx2_LLL(dim,nvec,basis,mpf_get_d(delta),ctl,&stats);
+    else if(PRECISION<=QD_PRECISION&&lll_fp_simd()&&lll_fp_fits(dim*nvec,basis))
+        done=qd_avx2_LLL(dim,nvec,basis,mpf_get_d(delta),ctl,&stats);
+    else
+#endif
+    if(PRECISION<=DD_PRECISION&&lll_fp_fits(dim*nvec,basis))
+        done=dd_LLL(dim,nvec,basis,mpf_get_d(delta),ctl,&stats);
+    else if(PRECISION<=QD_PRECISION&&lll_fp_fits(dim*nvec,basis))
+        done=qd_LLL(dim,nvec,basis,mpf_get_d(delta),ctl,&stats);
+    else
+#endif
+        done=LLL_mpf(dim,nvec,basis,delta,PRECISION,ctl,&stats);
+
+    if(ctl!=NULL&&ctl->stats!=NULL){
+        ctl->stats->iterations+=stats.iterations;
+        ctl->stats->swaps+=stats.swaps;
+        ctl->stats->size_reductions+=stats.size_reductions;
+        ctl->stats->gs_updates+=stats.gs_updates;
+    }
+    return done;
+}
+
+//LLL_ctl with the gram schmidt data in mpf_t of PRECISION bits. counts are added to stats
+int LLL_mpf(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION, lll_control *ctl, lll_stats *stats){
+    int j,k,s;
     int compare_int;
+    int iterations=0;
 
-    //initialize g.s. basis
-    mpf_t *obasis;
-    obasis=malloc(dim*nvec*sizeof(mpf_t));
-    for(i=0;i<(dim*nvec);i++)
-        mpf_init2(obasis[i],PRECISION);
+    //initialize g.s. basis (row major, one allocation)
+    mpf_t *obasis=mpf_array_init(dim*nvec,PRECISION);
 
     gram_schmidt(0,dim,nvec,basis,obasis,PRECISION);
+    stats->gs_updates++;
     k=1;
 
     //set dummy variables and intermediate variables
@@ -518,6 +723,8 @@ void LLL(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION){
 
     //LLL loop
     while(k<nvec){
+        if(++iterations%LLL_CHECK_EVERY==0&&(lll_should_stop_after(ctl,LLL_CHECK_EVERY)||lll_accept(ctl,basis,dim)))
+            break;
         for(j=k-1;j>=0;j--){
             gram_coef(dim,k,j,basis,obasis,mu,PRECISION);
             mpf_abs(dummy,mu);
@@ -533,6 +740,8 @@ void LLL(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION){
                 }
                 //update obasis (starting from basis[k])
                 gram_schmidt(k,dim,nvec,basis,obasis,PRECISION);
+                stats->size_reductions++;
+                stats->gs_updates++;
             }
         }
         //compute sq_norm(obasis[k],dim), save as dummy
@@ -557,19 +766,21 @@ void LLL(int dim, int nvec, mpz_t *basis, mpf_t delta, int PRECISION){
             }
             //update obasis (starting from basis[k-1])
             gram_schmidt(k-1,dim,nvec,basis,obasis,PRECISION);
+            stats->swaps++;
+            stats->gs_updates++;
             k=MAX(k-1,1);
         }
     }
 
-    for(i=0;i<(dim*nvec);i++)
-        mpf_clear(obasis[i]);
-    free(obasis);
+    mpf_array_clear(obasis,dim*nvec);
     mpz_clear(rnd);
     mpz_clear(dummyz);
     mpf_clear(dummy);
     mpf_clear(dummy2);
     mpf_clear(mu);
     mpfr_clear(mu2);
+    stats->iterations+=iterations;
+    return k>=nvec||(ctl!=NULL&&ctl->accepted);
 }
 
 //return index of vector in basis with shortest l2 length
@@ -591,10 +802,19 @@ int shortest_vec(int dim, int nvec, mpz_t *basis){
     return index_shortest;
 }
 
+//array of count mpf_t of PRECISION bits, side by side (row-major for a matrix), each initialized with mpf_init2.
+//release it with mpf_array_clear(arr,count)
+mpf_t *mpf_array_init(int count, int PRECISION){
+    int i;
+    mpf_t *arr=malloc(count*sizeof(mpf_t));
+    for(i=0;i<count;i++)
+        mpf_init2(arr[i],PRECISION);
+    return arr;
+}
 
-
-
-
-
-
-
+void mpf_array_clear(mpf_t *arr, int count){
+    int i;
+    for(i=0;i<count;i++)
+        mpf_clear(arr[i]);
+    free(arr);
+}
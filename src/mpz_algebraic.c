@@ -3,6 +3,9 @@
 #include <math.h>
 #include <time.h>
 #include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "lll_gs.h" //homemade libraries
 #include "lll_functions.h" //for polynomial print
 
@@ -22,6 +25,11 @@
 //this was able to find the min poly of 3*sqrt(2)+sqrt(3)+sqrt(5)+sqrt(7), which is degree 16, with about 750 bits of alpha in about 25 seconds. Not a simple minimal polynomial (huge coefficients!)
 //maybe try householder reflections instead of gram schmidt for LLL. not sure if LLL requires gs or not. 
 
+//non-interactive use: mpz_algebraic <number>... (or -f <file> with one number per line) prints, for each number, the relation
+//of lowest degree up to -maxdeg that holds to at least -tol digits beyond what its height explains (see relation_digits),
+//or "none". the degrees are searched in parallel, one LLL per degree on a pool of threads, and the LLLs of degrees above the
+//lowest relation found so far are cancelled. this also removes the need to guess the exact degree.
+
 //speedup ideas:
 //be smarter about gs inside lll- only update based on vectors that change. EDIT: made this change, about ~20-30% speed up. Less than I would have thought (was expecting closer to %50);
 
@@ -31,8 +39,346 @@
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define STR_MAX 8192 //maximum number of digits of alpha
+#define SWEEP_MAX_DEG 8 //default highest degree searched in batch mode
+#define SWEEP_TOL 10.0 //default digits a relation must hold beyond chance (see relation_digits)
+
+//degree sweep of one number, shared by the threads of find_relation
+typedef struct {
+    char *number; //alpha in base 10
+    int max_deg;
+    double tol;
+    int alg; //RELATION_LLL or RELATION_PSLQ
+    int verbose;
+    pthread_mutex_t lock; //for the fields below
+    int next_deg; //next degree to search
+    int best_deg; //degree of the lowest relation accepted so far, max_deg+1 if none
+    mpz_t *best; //that relation, max_deg+1 coefficients
+    volatile sig_atomic_t *cancel; //cancel[deg] stops the LLL of degree deg
+} sweep_state;
+
+int interactive(int alg);
+int batch(char **numbers, int count, int max_deg, double tol, int threads, int alg, int csv, int verbose);
+int find_relation(char *number, int max_deg, double tol, int threads, int alg, int verbose, mpz_t *rel);
+void *sweep_thread(void *arg);
+void sweep_degree(sweep_state *s, int deg);
+double relation_digits(mpz_t *rel, int len, const char *number, int PRECISION);
 
 int main(int argc, char *argv[]){
+    int i,count=0,ok;
+    int max_deg=SWEEP_MAX_DEG; //highest degree searched
+    double tol=SWEEP_TOL; //digits a relation must hold beyond chance
+    int threads=(int)sysconf(_SC_NPROCESSORS_ONLN); //threads of the degree sweep
+    int alg=RELATION_LLL; //LLL or PSLQ
+    int csv=0; //print relations as coefficient lists bool
+    int verbose=0; //print every degree's outcome on stderr bool
+    char *list_path=NULL; //file of numbers, one per line
+    char **numbers=malloc(argc*sizeof(char *)); //numbers given on the command line (then from the file)
+    char line[STR_MAX];
+    FILE *f;
+
+    for(i=1;i<argc;i++){
+        if(strcmp(argv[i],"-v")==0)
+            verbose=1; //verbosity option 
+        else if(strcmp(argv[i],"-maxdeg")==0&&i+1<argc)
+            max_deg=(int)strtol(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"-tol")==0&&i+1<argc)
+            tol=strtod(argv[++i],NULL);
+        else if(strcmp(argv[i],"-threads")==0&&i+1<argc)
+            threads=(int)strtol(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"-f")==0&&i+1<argc)
+            list_path=argv[++i];
+        else if(strcmp(argv[i],"-block")==0&&i+1<argc)
+            lll_block_size=MAX(0,(int)strtol(argv[++i],NULL,10)); //segment LLL (see LLL_segment in lll_fp.h)
+        else if(strcmp(argv[i],"-alg")==0&&i+1<argc){
+            alg=relation_alg(argv[++i]);
+            if(alg<0){
+                fprintf(stderr,"Unrecognized algorithm %s (lll or pslq)\n",argv[i]);
+                free(numbers);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i],"-csv")==0)
+            csv=1;
+        else if(argv[i][0]!='-'||isdigit((unsigned char)argv[i][1])||argv[i][1]=='.')
+            numbers[count++]=argv[i];
+        else{
+            fprintf(stderr,"Unrecognized option %s\n",argv[i]);
+            free(numbers);
+            return 1;
+        }
+    }
+    if(max_deg<=0){
+        fprintf(stderr,"Degree must be positive.\n");
+        free(numbers);
+        return 1;
+    }
+
+    //no numbers: ask for one
+    if(count==0&&list_path==NULL){
+        free(numbers);
+        return interactive(alg);
+    }
+
+    //numbers from a file, after those on the command line
+    if(list_path!=NULL){
+        f=strcmp(list_path,"-")==0 ? stdin : fopen(list_path,"r");
+        if(f==NULL){
+            fprintf(stderr,"Could not open %s\n",list_path);
+            free(numbers);
+            return 1;
+        }
+        while(fgets(line,STR_MAX,f)!=NULL){
+            line[strcspn(line," \t\r\n")]='\0';
+            if(line[0]=='\0')
+                continue;
+            numbers=realloc(numbers,(count+1)*sizeof(char *));
+            numbers[count]=malloc(strlen(line)+1);
+            strcpy(numbers[count++],line);
+        }
+        if(f!=stdin)
+            fclose(f);
+    }
+
+    ok=batch(numbers,count,max_deg,tol,MAX(1,threads),alg,csv,verbose);
+    //(the strings read from the file are freed with the process)
+    free(numbers);
+    return !ok;
+}
+
+//find and print the relation of each of the numbers (one line each, "none" if there isn't one)
+//return 0 if any number failed
+int batch(char **numbers, int count, int max_deg, double tol, int threads, int alg, int csv, int verbose){
+    int i,j,ok=1;
+    mpz_t *rel=malloc((max_deg+1)*sizeof(mpz_t));
+    for(j=0;j<=max_deg;j++)
+        mpz_init(rel[j]);
+    for(i=0;i<count;i++){
+        if(!find_relation(numbers[i],max_deg,tol,threads,alg,verbose,rel)){
+            printf("none\n");
+            ok=0;
+        }
+        else if(csv){
+            for(j=0;j<=degree(rel,max_deg+1);j++){
+                mpz_out_str(stdout,10,rel[j]);
+                printf(j<degree(rel,max_deg+1) ? "," : "\n");
+            }
+        }
+        else
+            print_poly(degree(rel,max_deg+1)+1,rel,1);
+        fflush(stdout);
+    }
+    for(j=0;j<=max_deg;j++)
+        mpz_clear(rel[j]);
+    free(rel);
+    return ok;
+}
+
+//set rel (max_deg+1 coefficients) to the relation of lowest degree on number, primitive with positive leading coefficient,
+//searching degrees 1,...,max_deg on the given number of threads with alg. return 0 if there is none (or number is invalid)
+int find_relation(char *number, int max_deg, double tol, int threads, int alg, int verbose, mpz_t *rel){
+    int i,found;
+    sweep_state s;
+    pthread_t *thread;
+    mpf_t alpha;
+
+    if(strlen(number)>=STR_MAX){
+        fprintf(stderr,"Number too long (at most %d digits): %.20s...\n",STR_MAX-1,number);
+        return 0;
+    }
+    mpf_init2(alpha,(int)(strlen(number)*log2(10))+64);
+    if(mpf_set_str(alpha,number,10)){
+        fprintf(stderr,"read error! Input must only contain 0-9 and at most one '.' and 'e': %s\n",number);
+        mpf_clear(alpha);
+        return 0;
+    }
+    //an integer n is a root of x-n
+    if(mpf_integer_p(alpha)){
+        for(i=0;i<=max_deg;i++)
+            mpz_set_ui(rel[i],0);
+        mpz_set_f(rel[0],alpha);
+        mpz_neg(rel[0],rel[0]);
+        mpz_set_ui(rel[1],1);
+        mpf_clear(alpha);
+        return 1;
+    }
+    mpf_clear(alpha);
+
+    s.number=number;
+    s.max_deg=max_deg;
+    s.tol=tol;
+    s.alg=alg;
+    s.verbose=verbose;
+    pthread_mutex_init(&s.lock,NULL);
+    s.next_deg=1;
+    s.best_deg=max_deg+1;
+    s.best=rel;
+    s.cancel=malloc((max_deg+1)*sizeof(sig_atomic_t));
+    for(i=0;i<=max_deg;i++)
+        s.cancel[i]=0;
+#ifndef LLL_MPF_ONLY
+    lll_fp_simd(); //detect the cpu before there are threads
+#endif
+
+    //the calling thread is one of the workers
+    threads=MIN(threads,max_deg);
+    thread=malloc(threads*sizeof(pthread_t));
+    for(i=1;i<threads;i++){
+        if(pthread_create(&thread[i],NULL,sweep_thread,&s)!=0)
+            break;
+    }
+    threads=i;
+    sweep_thread(&s);
+    for(i=1;i<threads;i++)
+        pthread_join(thread[i],NULL);
+
+    found=s.best_deg<=max_deg;
+    if(!found)
+        fprintf(stderr,"No relation of degree at most %d found for %s\n",max_deg,number);
+    pthread_mutex_destroy(&s.lock);
+    free((void *)s.cancel);
+    free(thread);
+    return found;
+}
+
+//take degrees off the sweep until there are none left worth searching
+void *sweep_thread(void *arg){
+    sweep_state *s=arg;
+    int deg;
+    for(;;){
+        pthread_mutex_lock(&s->lock);
+        deg=s->next_deg++;
+        if(deg>=s->best_deg) //(also past max_deg)
+            deg=0;
+        pthread_mutex_unlock(&s->lock);
+        if(deg==0){
+            mpfr_free_cache(); //mpfr's constant caches (pi in pslq) are per thread, and would be lost with it
+            return NULL;
+        }
+        sweep_degree(s,deg);
+    }
+}
+
+//search for a relation of degree deg on s->number, and keep it if it beats s->best
+void sweep_degree(sweep_state *s, int deg){
+    int i,len,sig_digits,PRECISION;
+    double digits;
+    lll_control ctl={0,&s->cancel[deg],0,NULL,NULL,NULL,0,0,0};
+    mpf_t alpha,delta;
+    mpc_t alpha_cx;
+    power_table powers;
+    mpz_t *basis,*rel;
+
+    //as in interactive mode: precision from the digits given
+    sig_digits=sig(s->number,deg);
+    PRECISION=(int)(sig_digits*log2(10))+3;
+    mpf_init2(alpha,PRECISION);
+    mpf_set_str(alpha,s->number,10);
+    mpf_init2(delta,PRECISION);
+    mpf_set_d(delta,0.75); //LLL parameter
+
+    basis=malloc((deg+1)*(deg+2)*sizeof(mpz_t));
+    for(i=0;i<(deg+1)*(deg+2);i++)
+        mpz_init(basis[i]);
+
+    if(s->alg==RELATION_PSLQ){
+        //the relation goes to the first deg+1 entries of basis
+        mpc_init2(alpha_cx,PRECISION);
+        mpfr_set_f(mpc_realref(alpha_cx),alpha,MPFR_RNDN);
+        mpfr_set_ui(mpc_imagref(alpha_cx),0,MPFR_RNDN);
+        power_table_init(&powers,alpha_cx,deg,PRECISION);
+        i=pslq_poly_cx(&powers,deg,basis,NULL,&ctl);
+        power_table_clear(&powers);
+        mpc_clear(alpha_cx);
+        rel=basis;
+    }
+    else{
+        create_basis(basis,alpha,deg,sig_digits,PRECISION);
+        i=LLL_ctl(deg+2,deg+1,basis,delta,PRECISION,&ctl);
+        rel=&basis[shortest_vec(deg+2,deg+1,basis)*(deg+2)]; //its first deg+1 entries
+    }
+    if(i){
+        len=(primitive_slide(deg+1,rel)>=0) ? degree(rel,deg+1)+1 : 0;
+        digits=len>1 ? relation_digits(rel,len,s->number,PRECISION) : 0;
+        if(s->verbose)
+            fprintf(stderr,"%s degree %d: relation of degree %d holding to %.1f digits beyond chance\n",s->number,deg,len-1,digits);
+        if(len>1&&digits>=s->tol){
+            pthread_mutex_lock(&s->lock);
+            if(len-1<s->best_deg){
+                s->best_deg=len-1;
+                for(i=0;i<=s->max_deg;i++){
+                    if(i<len)
+                        mpz_set(s->best[i],rel[i]);
+                    else
+                        mpz_set_ui(s->best[i],0);
+                }
+                //higher degrees can't beat it
+                for(i=len;i<=s->max_deg;i++)
+                    s->cancel[i]=1;
+            }
+            pthread_mutex_unlock(&s->lock);
+        }
+    }
+    else if(s->verbose)
+        fprintf(stderr,"%s degree %d: %s\n",s->number,deg,lll_should_stop(&ctl) ? "cancelled" : "no relation");
+
+    for(i=0;i<(deg+1)*(deg+2);i++)
+        mpz_clear(basis[i]);
+    free(basis);
+    mpf_clear(alpha);
+    mpf_clear(delta);
+}
+
+//number of digits by which rel (of degree d=len-1, height H) vanishes at alpha beyond what LLL finds by chance:
+//-log10|rel(alpha)| - d*log10(H) + d*log10(max(1,|alpha|)). LLL on D digits returns relations of about that height
+//whatever alpha is, and those vanish to about d*log10(H/max(1,|alpha|)) digits, so this is close to 0 for them;
+//a true relation vanishes to about D digits instead. alpha is read again from number, at a precision beyond PRECISION
+double relation_digits(mpz_t *rel, int len, const char *number, int PRECISION){
+    int i,d=len-1;
+    long e;
+    double digits,m;
+    mpf_t alpha,value,coef;
+    mpz_t height;
+
+    PRECISION=2*PRECISION+64;
+    mpf_init2(alpha,PRECISION);
+    mpf_init2(value,PRECISION);
+    mpf_init2(coef,PRECISION);
+    mpz_init(height);
+    mpf_set_str(alpha,number,10);
+
+    //Horner's method
+    mpf_set_z(value,rel[d]);
+    for(i=d-1;i>=0;i--){
+        mpf_mul(value,value,alpha);
+        mpf_set_z(coef,rel[i]);
+        mpf_add(value,value,coef);
+    }
+    if(mpf_sgn(value)==0)
+        digits=HUGE_VAL;
+    else{
+        m=mpf_get_d_2exp(&e,value);
+        digits=-(log10(fabs(m))+e*log10(2.0));
+        for(i=0;i<len;i++){
+            if(mpz_cmpabs(rel[i],height)>0)
+                mpz_abs(height,rel[i]);
+        }
+        m=mpz_get_d_2exp(&e,height);
+        digits-=d*(log10(m)+e*log10(2.0));
+        mpf_abs(alpha,alpha);
+        if(mpf_cmp_ui(alpha,1)>0){
+            m=mpf_get_d_2exp(&e,alpha);
+            digits+=d*(log10(m)+e*log10(2.0));
+        }
+    }
+    mpz_clear(height);
+    mpf_clear(alpha);
+    mpf_clear(value);
+    mpf_clear(coef);
+    return digits;
+}
+
+//read one number and degree through prompts, and print the lattice and likely minimal polynomial
+int interactive(int alg){
     int deg,i,input_fail,past_dot,precision_given;
     int PRECISION;//,ACC;
     int sig_digits=0;
@@ -42,11 +388,6 @@ int main(int argc, char *argv[]){
     mpf_t alpha; //input float
     mpf_t delta; //LLL parameter
 
-    if(argc==2){
-        if(strcmp(argv[1],"-v")==0)
-            verbose=1; //verbosity option 
-    }
-
     //print statements and variable reading
     printf("_____________________________________________\n\n");
     printf("|     Check that a number is algebraic      |\n");
@@ -117,8 +458,9 @@ int main(int argc, char *argv[]){
     for(i=0;i<(deg+1)*(deg+2);i++){
         mpz_init(basis[i]);	
     }
-    create_basis(basis,alpha,deg,sig_digits,PRECISION);
-    if(verbose){
+    if(alg==RELATION_LLL)
+        create_basis(basis,alpha,deg,sig_digits,PRECISION);
+    if(verbose&&alg==RELATION_LLL){
         printf("Initial lattice basis:\n");
         print_matrix_i(deg+2,deg+1,10,basis);
     }
@@ -129,11 +471,25 @@ int main(int argc, char *argv[]){
         printf("---------------------------------------------\n\n");
     }
 
-    //perform LLL
+    //perform LLL (or PSLQ, whose relation goes to the first vector)
     clock_t start=clock(),diff;
-    LLL(deg+2,deg+1,basis,delta,PRECISION);
+    int found=1;
+    if(alg==RELATION_PSLQ){
+        mpc_t alpha_cx; mpc_init2(alpha_cx,PRECISION);
+        mpfr_set_f(mpc_realref(alpha_cx),alpha,MPFR_RNDN);
+        mpfr_set_ui(mpc_imagref(alpha_cx),0,MPFR_RNDN);
+        power_table powers; power_table_init(&powers,alpha_cx,deg,PRECISION);
+        if(!pslq_poly_cx(&powers,deg,basis,NULL,NULL)){
+            printf("No relation found, try a higher degree or more digits.\n");
+            found=0;
+        }
+        power_table_clear(&powers);
+        mpc_clear(alpha_cx);
+    }
+    else
+        LLL(deg+2,deg+1,basis,delta,PRECISION);
     diff=clock()-start;
-    if(verbose){
+    if(verbose&&alg==RELATION_LLL){
         printf("\nReduced lattice basis:\n");
         print_matrix_i(deg+2,deg+1,10,basis);
     }
@@ -141,15 +497,16 @@ int main(int argc, char *argv[]){
     int msec_time= diff *1000/CLOCKS_PER_SEC;
 
     //pick out shortest vector, divide by largest power of x dividing the polynomial it represents
-    printf("Likely minimal polynomial:\n");
-
     int poly_len=deg+1;
-    i=0;
-    while(mpz_sgn(basis[i])==0){
-        i++;
-        poly_len--;
+    if(found){
+        printf("Likely minimal polynomial:\n");
+        i=0;
+        while(poly_len>1&&mpz_sgn(basis[i])==0){
+            i++;
+            poly_len--;
+        }
+        print_poly(poly_len,&basis[i],1);
     }
-    print_poly(poly_len,&basis[i],1);
     if(verbose)
         printf("\nTime: \n%d.%ds\n",msec_time/1000,msec_time%1000);
 
@@ -159,7 +516,7 @@ int main(int argc, char *argv[]){
     for(i=0;i<(deg+1)*(deg+2);i++)
         mpz_clear(basis[i]);
     free(basis);
-    return 1;
+    return found;
 }
 
 
@@ -0,0 +1,278 @@
+//---------about-----------------//
+
+//PSLQ integer relation algorithm (Ferguson, Bailey and Arno, 1999): given real x_0,...,x_{n-1}, find integers
+//r_0,...,r_{n-1}, not all zero, with r_0*x_0+...+r_{n-1}*x_{n-1}=0 (to the working precision).
+//an alternative to LLL on the create_basis/create_basis_cx lattices for finding minimal polynomials: it works on the
+//powers of alpha directly, so there is no scaling by 10^sig_digits to choose, and it gives a lower bound on the
+//norm of any relation as it goes, so it can stop as soon as a relation of a given size is ruled out.
+
+//---------notes-----------------//
+
+//one-level PSLQ in mpfr, with the reduction matrix B kept in mpz. only B (the inverse of the usual A) is kept:
+//y = x*B throughout, so a column j of B with y_j = 0 is a relation.
+//a relation is accepted once |y_j| drops below 2^(b-PRECISION+PSLQ_NOISE), b being the bits of the largest entry of B
+//(rounding in y = x*B is about 2^(b-PRECISION); much more slack lets chance near-relations through on small n),
+//and the search gives up once those entries reach PRECISION-PSLQ_SLACK bits (the precision is used up).
+//the iterations run at PRECISION+PSLQ_SLACK bits.
+
+#include <string.h>
+
+#define PSLQ_GAMMA 1.1547005383792517 //sqrt(4/3), the usual choice (the algorithm needs gamma>=sqrt(4/3))
+#define PSLQ_SLACK 32 //bits
+#define PSLQ_NOISE 16 //bits
+#define PSLQ_CHECK_EVERY 8 //iterations between two checks of lll_control
+
+//how minimal polynomials are found
+#define RELATION_LLL 0 //LLL on create_basis(_cx)
+#define RELATION_PSLQ 1 //pslq_poly_cx
+
+int pslq(int n, mpfr_t *x, mpz_t *rel, mpz_srcptr bound, int PRECISION, lll_control *ctl);
+void pslq_reduce(int n, int i, int j, mpfr_t *H, mpfr_t *y, mpz_t *B, mpfr_t t, mpz_t q, lll_stats *stats);
+int pslq_poly_cx(const power_table *pt, int deg, mpz_t *rel, mpz_srcptr bound, lll_control *ctl);
+int relation_alg(const char *name);
+
+//find an integer relation rel[0..n-1] on x[0..n-1] (n>=2). if bound is not NULL, give up once every relation is known
+//to be longer (in l2 norm) than bound. return 1 if found, 0 if not (or if ctl stopped it)
+int pslq(int n, mpfr_t *x, mpz_t *rel, mpz_srcptr bound, int PRECISION, lll_control *ctl){
+    int i,j,k,m,iter=0,found=-1,wp=PRECISION+PSLQ_SLACK;
+    size_t bits;
+    lll_stats stats={0,0,0,0};
+    mpfr_t *H=malloc(n*(n-1)*sizeof(mpfr_t)); //n x (n-1), row-major
+    mpfr_t *y=malloc(n*sizeof(mpfr_t));
+    mpfr_t *s=malloc(n*sizeof(mpfr_t));
+    mpfr_t *gamma_pow=malloc((n-1)*sizeof(mpfr_t)); //gamma^(j+1)
+    mpz_t *B=malloc(n*n*sizeof(mpz_t)); //n x n, row-major
+    mpfr_t t,t0,t1,t2,t3,t4;
+    mpz_t q;
+
+    for(i=0;i<n*(n-1);i++)
+        mpfr_init2(H[i],wp);
+    for(i=0;i<n;i++){
+        mpfr_init2(y[i],wp);
+        mpfr_init2(s[i],wp);
+    }
+    for(i=0;i<n-1;i++)
+        mpfr_init2(gamma_pow[i],wp);
+    for(i=0;i<n*n;i++)
+        mpz_init_set_ui(B[i],(i/n)==(i%n));
+    mpfr_init2(t,wp);
+    mpfr_init2(t0,wp);
+    mpfr_init2(t1,wp);
+    mpfr_init2(t2,wp);
+    mpfr_init2(t3,wp);
+    mpfr_init2(t4,wp);
+    mpz_init(q);
+
+    //a zero entry is a relation by itself
+    for(i=0;i<n&&found<0;i++){
+        if(mpfr_zero_p(x[i]))
+            found=i;
+    }
+
+    if(found<0){
+        //s_j = |(x_j,...,x_{n-1})|, then y = x/s_0 and s = s/s_0
+        mpfr_sqr(s[n-1],x[n-1],MPFR_RNDN);
+        for(j=n-2;j>=0;j--){
+            mpfr_sqr(t,x[j],MPFR_RNDN);
+            mpfr_add(s[j],s[j+1],t,MPFR_RNDN);
+        }
+        for(j=0;j<n;j++)
+            mpfr_sqrt(s[j],s[j],MPFR_RNDN);
+        for(j=0;j<n;j++)
+            mpfr_div(y[j],x[j],s[0],MPFR_RNDN);
+        for(j=n-1;j>=0;j--)
+            mpfr_div(s[j],s[j],s[0],MPFR_RNDN);
+
+        //H_ij = 0 (i<j), s_{j+1}/s_j (i=j), -y_i*y_j/(s_j*s_{j+1}) (i>j)
+        for(i=0;i<n;i++){
+            for(j=0;j<n-1;j++){
+                if(i<j)
+                    mpfr_set_ui(H[i*(n-1)+j],0,MPFR_RNDN);
+                else if(i==j)
+                    mpfr_div(H[i*(n-1)+j],s[j+1],s[j],MPFR_RNDN);
+                else{
+                    mpfr_mul(t,y[i],y[j],MPFR_RNDN);
+                    mpfr_mul(t0,s[j],s[j+1],MPFR_RNDN);
+                    mpfr_div(t,t,t0,MPFR_RNDN);
+                    mpfr_neg(H[i*(n-1)+j],t,MPFR_RNDN);
+                }
+            }
+        }
+        mpfr_set_d(t,PSLQ_GAMMA,MPFR_RNDN);
+        mpfr_set(gamma_pow[0],t,MPFR_RNDN);
+        for(j=1;j<n-1;j++)
+            mpfr_mul(gamma_pow[j],gamma_pow[j-1],t,MPFR_RNDN);
+
+        //full reduction of H
+        for(i=1;i<n;i++){
+            for(j=i-1;j>=0;j--)
+                pslq_reduce(n,i,j,H,y,B,t,q,&stats);
+        }
+    }
+
+    while(found<0){
+        if(++iter%PSLQ_CHECK_EVERY==0&&lll_should_stop(ctl))
+            break;
+
+        //a relation: some y_j at the noise level of B
+        bits=1;
+        for(i=0;i<n*n;i++)
+            bits=MAX(bits,mpz_sizeinbase(B[i],2));
+        if((long)bits>=PRECISION-PSLQ_SLACK)
+            break; //precision used up
+        mpfr_set_ui_2exp(t0,1,(long)bits-PRECISION+PSLQ_NOISE,MPFR_RNDN);
+        for(j=0;j<n&&found<0;j++){
+            if(mpfr_cmpabs(y[j],t0)<=0)
+                found=j;
+        }
+        if(found>=0)
+            break;
+        if(mpfr_zero_p(H[(n-2)*(n-1)+n-2])){
+            found=n-1;
+            break;
+        }
+
+        //every relation is longer than 1/max|H_jj|
+        if(bound!=NULL){
+            mpfr_set_ui(t0,0,MPFR_RNDN);
+            for(j=0;j<n-1;j++){
+                mpfr_abs(t1,H[j*(n-1)+j],MPFR_RNDN);
+                mpfr_max(t0,t0,t1,MPFR_RNDN);
+            }
+            mpfr_mul_z(t0,t0,bound,MPFR_RNDN);
+            if(mpfr_cmp_ui(t0,1)<0)
+                break;
+        }
+
+        stats.iterations++;
+
+        //exchange: m maximizing gamma^(m+1)*|H_mm|
+        m=0;
+        for(j=0;j<n-1;j++){
+            mpfr_abs(t0,H[j*(n-1)+j],MPFR_RNDN);
+            mpfr_mul(t0,t0,gamma_pow[j],MPFR_RNDN);
+            if(j==0||mpfr_cmp(t0,t1)>0){
+                m=j;
+                mpfr_set(t1,t0,MPFR_RNDN);
+            }
+        }
+        mpfr_swap(y[m],y[m+1]);
+        for(j=0;j<n-1;j++)
+            mpfr_swap(H[m*(n-1)+j],H[(m+1)*(n-1)+j]);
+        for(k=0;k<n;k++)
+            mpz_swap(B[k*n+m],B[k*n+m+1]);
+        stats.swaps++;
+
+        //corner: rotate columns m,m+1 to keep H lower trapezoidal
+        if(m<n-2){
+            mpfr_sqr(t0,H[m*(n-1)+m],MPFR_RNDN);
+            mpfr_sqr(t1,H[m*(n-1)+m+1],MPFR_RNDN);
+            mpfr_add(t0,t0,t1,MPFR_RNDN);
+            mpfr_sqrt(t0,t0,MPFR_RNDN);
+            mpfr_div(t1,H[m*(n-1)+m],t0,MPFR_RNDN);
+            mpfr_div(t2,H[m*(n-1)+m+1],t0,MPFR_RNDN);
+            for(i=m;i<n;i++){
+                mpfr_set(t3,H[i*(n-1)+m],MPFR_RNDN);
+                mpfr_set(t4,H[i*(n-1)+m+1],MPFR_RNDN);
+                mpfr_mul(t,t1,t3,MPFR_RNDN);
+                mpfr_fma(H[i*(n-1)+m],t2,t4,t,MPFR_RNDN);
+                mpfr_mul(t,t2,t3,MPFR_RNDN);
+                mpfr_fms(H[i*(n-1)+m+1],t1,t4,t,MPFR_RNDN);
+            }
+        }
+
+        //reduction of the rows below m
+        for(i=m+1;i<n;i++){
+            for(j=MIN(i-1,m+1);j>=0;j--)
+                pslq_reduce(n,i,j,H,y,B,t,q,&stats);
+        }
+
+    }
+
+    if(found>=0){
+        for(k=0;k<n;k++)
+            mpz_set(rel[k],B[k*n+found]);
+    }
+    if(ctl!=NULL&&ctl->stats!=NULL){
+        ctl->stats->iterations+=stats.iterations;
+        ctl->stats->swaps+=stats.swaps;
+        ctl->stats->size_reductions+=stats.size_reductions;
+    }
+
+    for(i=0;i<n*(n-1);i++)
+        mpfr_clear(H[i]);
+    for(i=0;i<n;i++){
+        mpfr_clear(y[i]);
+        mpfr_clear(s[i]);
+    }
+    for(i=0;i<n-1;i++)
+        mpfr_clear(gamma_pow[i]);
+    for(i=0;i<n*n;i++)
+        mpz_clear(B[i]);
+    mpfr_clear(t);
+    mpfr_clear(t0);
+    mpfr_clear(t1);
+    mpfr_clear(t2);
+    mpfr_clear(t3);
+    mpfr_clear(t4);
+    mpz_clear(q);
+    free(H);
+    free(y);
+    free(s);
+    free(gamma_pow);
+    free(B);
+    return found>=0;
+}
+
+//size-reduce row i of H by row j (j<i): subtract round(H_ij/H_jj) times it, updating y and B to match. t, q are scratch
+void pslq_reduce(int n, int i, int j, mpfr_t *H, mpfr_t *y, mpz_t *B, mpfr_t t, mpz_t q, lll_stats *stats){
+    int k;
+    if(mpfr_zero_p(H[j*(n-1)+j]))
+        return;
+    mpfr_div(t,H[i*(n-1)+j],H[j*(n-1)+j],MPFR_RNDN);
+    mpfr_round(t,t);
+    if(mpfr_zero_p(t))
+        return;
+    mpfr_get_z(q,t,MPFR_RNDN);
+    stats->size_reductions++;
+    for(k=0;k<=j;k++){
+        mpfr_mul_z(t,H[j*(n-1)+k],q,MPFR_RNDN);
+        mpfr_sub(H[i*(n-1)+k],H[i*(n-1)+k],t,MPFR_RNDN);
+    }
+    mpfr_mul_z(t,y[i],q,MPFR_RNDN);
+    mpfr_add(y[j],y[j],t,MPFR_RNDN);
+    for(k=0;k<n;k++)
+        mpz_addmul(B[k*n+j],q,B[k*n+i]);
+}
+
+//find a polynomial rel[0..deg] with root alpha by pslq on its powers (from pt, deg<=pt->n). a complex alpha is handled
+//through the real numbers Re(alpha^i)+theta*Im(alpha^i), theta=pi/4: a relation on these is (barring coincidence) one on
+//both parts. bound as in pslq. return 1 if found
+int pslq_poly_cx(const power_table *pt, int deg, mpz_t *rel, mpz_srcptr bound, lll_control *ctl){
+    int i,found;
+    mpfr_t *x=malloc((deg+1)*sizeof(mpfr_t));
+    mpfr_t theta; mpfr_init2(theta,pt->PRECISION);
+
+    mpfr_const_pi(theta,MPFR_RNDN);
+    mpfr_div_2ui(theta,theta,2,MPFR_RNDN);
+    for(i=0;i<=deg;i++){
+        mpfr_init2(x[i],pt->PRECISION);
+        mpfr_fma(x[i],mpc_imagref(pt->pow[i]),theta,mpc_realref(pt->pow[i]),MPFR_RNDN);
+    }
+    found=pslq(deg+1,x,rel,bound,pt->PRECISION,ctl);
+
+    for(i=0;i<=deg;i++)
+        mpfr_clear(x[i]);
+    free(x);
+    mpfr_clear(theta);
+    return found;
+}
+
+//RELATION_LLL or RELATION_PSLQ from a command line name ("lll" or "pslq"), -1 if neither
+int relation_alg(const char *name){
+    if(strcmp(name,"lll")==0)
+        return RELATION_LLL;
+    if(strcmp(name,"pslq")==0)
+        return RELATION_PSLQ;
+    return -1;
+}
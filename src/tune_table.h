@@ -0,0 +1,58 @@
+//---------about-----------------//
+
+//lookup table of precision/delta defaults per input class, written by utils/tune.py.
+//lll_factor reads it (-tune <file>, or the file named by POLY_FACTOR_TUNE_TABLE) when -p or -d are not given.
+
+//---------notes-----------------//
+
+//file format: text, one row per class, lines starting with # are comments:
+//    <max degree> <max height bits> <precision> <delta>
+//the height of a polynomial is its largest |coefficient|, measured in bits. a bound of -1 means unbounded.
+//rows are checked in order and the first one containing the input is used, so they go from small to large classes.
+
+#define TUNE_TABLE_ENV "POLY_FACTOR_TUNE_TABLE"
+
+int height_bits(mpz_t *p, int len);
+int tune_lookup(const char *path, int degree, int bits, int *PRECISION, double *delta);
+
+//number of bits of the largest coefficient of p
+int height_bits(mpz_t *p, int len){
+    int i,bits=0;
+    for(i=0;i<len;i++){
+        if(mpz_sgn(p[i])!=0)
+            bits=MAX(bits,(int)mpz_sizeinbase(p[i],2));
+    }
+    return bits;
+}
+
+//find the row for a polynomial of given degree and height in the table at path, and set PRECISION and delta from it.
+//return 1 if a row was found, 0 otherwise (or if the file can't be read), leaving PRECISION and delta alone
+int tune_lookup(const char *path, int degree, int bits, int *PRECISION, double *delta){
+    FILE *f;
+    char line[256];
+    int max_degree,max_bits,row_precision,lineno=0;
+    double row_delta;
+
+    f=fopen(path,"r");
+    if(f==NULL){
+        fprintf(stderr,"Could not open tuning table %s\n",path);
+        return 0;
+    }
+    while(fgets(line,sizeof(line),f)!=NULL){
+        lineno++;
+        if(line[0]=='#'||line[0]=='\n')
+            continue;
+        if(sscanf(line,"%d %d %d %lf",&max_degree,&max_bits,&row_precision,&row_delta)!=4||row_precision<32||row_delta<=0.25||row_delta>=1){
+            fprintf(stderr,"Invalid tuning table %s (line %d)\n",path,lineno);
+            break;
+        }
+        if((max_degree<0||degree<=max_degree)&&(max_bits<0||bits<=max_bits)){
+            *PRECISION=row_precision;
+            *delta=row_delta;
+            fclose(f);
+            return 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,122 @@
+"""
+Benchmark lll_factor on the corpus generated by utils/make_corpus.py.
+
+Every polynomial is factored once for each combination of precision (-p) and LLL
+parameter (-d). Each run records wall time, CPU time and peak memory of the process,
+the per-phase timings of lll_factor -stats, and whether the factorization is correct
+(complete, and the product of the factors is the input). One csv row is written per
+run; a summary per category and setting is printed at the end.
+
+Usage: python3 -m utils.bench data/corpus.csv bench_output.csv [-p 64 128] [-d 0.5 0.75]
+"""
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+from collections import defaultdict
+
+from utils.make_corpus import multiply
+from utils.std_parse import parse_output_json
+
+STATS_KEYS = ["squarefree_ms", "database_ms", "root_ms", "basis_ms", "lll_ms", "divide_ms",
+              "multiplicity_ms", "lll_iterations", "swaps"]
+FIELDS = ["name", "category", "degree", "precision", "delta", "success", "factors",
+          "wall_ms", "cpu_ms", "max_rss_kb"] + STATS_KEYS
+
+
+def expand(coefficients):
+    """Product of factors^multiplicity."""
+    r = [1]
+    for coefs, mult in coefficients:
+        for _ in range(mult):
+            r = multiply(r, coefs)
+    while len(r) > 1 and r[-1] == 0:
+        r.pop()
+    return r
+
+
+def run_one(binary, coefs, precision, delta, timeout_ms, extra):
+    """Run lll_factor once; return a dict with the measurements."""
+    command = [binary, ",".join(map(str, coefs)), "-p", str(precision), "-d", str(delta),
+               "-json", "-stats", "-timeout", str(timeout_ms)] + extra
+    with tempfile.TemporaryFile() as out, tempfile.TemporaryFile() as err:
+        start = time.monotonic()
+        proc = subprocess.Popen(command, stdout=out, stderr=err)
+        # wait4 gives the usage of this child alone (RUSAGE_CHILDREN would accumulate over all runs)
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.monotonic() - start
+        proc.returncode = os.waitstatus_to_exitcode(status)
+        out.seek(0)
+        err.seek(0)
+        out, err = out.read().decode("utf-8"), err.read().decode("utf-8")
+
+    row = {
+        "wall_ms": round(1e3 * wall, 3),
+        "cpu_ms": round(1e3 * (usage.ru_utime + usage.ru_stime), 3),
+        "max_rss_kb": usage.ru_maxrss,  # never below the size of this (forking) process
+        "success": 0,
+        "factors": 0,
+    }
+    for line in err.splitlines():
+        if line.startswith("{"):
+            totals = json.loads(line)["totals"]
+            row.update({k: totals[k] for k in STATS_KEYS})
+
+    if proc.returncode == 0:
+        parsed = parse_output_json(out)
+        row["factors"] = len(parsed["coefficients"])
+        row["success"] = int(parsed["complete"] and expand(parsed["coefficients"]) == coefs)
+    return row
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("corpus")
+    parser.add_argument("output")
+    parser.add_argument("-p", "--precisions", type=int, nargs="+", default=[64, 128, 256])
+    parser.add_argument("-d", "--deltas", type=float, nargs="+", default=[0.5, 0.75])
+    parser.add_argument("--binary", default="bin/lll_factor")
+    parser.add_argument("--timeout", type=int, default=20000, help="per run, in ms")
+    parser.add_argument("--category", nargs="+", help="only run these categories")
+    parser.add_argument("--db", help="factor database passed with -db")
+    parser.add_argument("--seed", type=int, help="passed with -seed (runs with the same seed are reproducible)")
+    args = parser.parse_args()
+
+    with open(args.corpus, newline="") as f:
+        corpus = [r for r in csv.DictReader(f) if not args.category or r["category"] in args.category]
+    extra = ["-db", args.db] if args.db else []
+    if args.seed is not None:
+        extra += ["-seed", str(args.seed)]
+
+    summary = defaultdict(list)
+    with open(args.output, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        for precision in args.precisions:
+            for delta in args.deltas:
+                for entry in corpus:
+                    coefs = [int(c) for c in entry["coefficients"].split(",")]
+                    row = run_one(args.binary, coefs, precision, delta, args.timeout, extra)
+                    row.update(name=entry["name"], category=entry["category"], degree=entry["degree"],
+                               precision=precision, delta=delta)
+                    writer.writerow(row)
+                    f.flush()
+                    summary[(entry["category"], precision, delta)].append(row)
+
+    print(f"{'category':<14}{'-p':>6}{'-d':>6}{'success':>10}{'mean ms':>12}{'max ms':>12}{'max kB':>10}")
+    for (category, precision, delta), rows in sorted(summary.items()):
+        ok = sum(r["success"] for r in rows)
+        times = [r["wall_ms"] for r in rows]
+        rss = max(r["max_rss_kb"] for r in rows)
+        print(f"{category:<14}{precision:>6}{delta:>6}{f'{ok}/{len(rows)}':>10}"
+              f"{sum(times) / len(times):>12.1f}{max(times):>12.1f}{rss:>10}")
+    print(f"results written to {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+"""
+Factorization cache for the API.
+
+Results are keyed by a hash of the canonical coefficient vector (lowest degree
+first, no trailing zeros). Besides whole results, every irreducible factor seen
+is remembered, so that a new polynomial can be stripped of known factors by
+trial division before the remaining cofactor is sent to lll_factor.
+
+The in-memory store is an LRU; set db_path to also persist everything to SQLite.
+"""
+
+import hashlib
+import json
+import sqlite3
+import threading
+from collections import OrderedDict
+
+
+def canonical(coefs):
+    """Strip trailing zero coefficients."""
+    coefs = [int(c) for c in coefs]
+    while len(coefs) > 1 and coefs[-1] == 0:
+        coefs.pop()
+    return coefs
+
+
+def poly_key(coefs):
+    """Canonical hash of a coefficient vector."""
+    s = ",".join(map(str, canonical(coefs)))
+    return hashlib.sha256(s.encode("utf-8")).hexdigest()
+
+
+def exact_divide(p, d):
+    """Return q with p = d*q in Z[x], or None if d does not divide p exactly."""
+    p = canonical(p)
+    d = canonical(d)
+    n, m = len(p) - 1, len(d) - 1
+    if m > n or (m == 0 and d[0] == 0):
+        return None
+    rem = list(p)
+    q = [0] * (n - m + 1)
+    for i in range(n - m, -1, -1):
+        c, r = divmod(rem[i + m], d[m])
+        if r != 0:
+            return None
+        q[i] = c
+        if c != 0:
+            for j in range(m + 1):
+                rem[i + j] -= c * d[j]
+    if any(rem[:m]):
+        return None
+    return q
+
+
+class FactorCache:
+    def __init__(self, max_entries=1024, max_factors=4096, db_path=None):
+        self.max_entries = max_entries
+        self.max_factors = max_factors
+        self.results = OrderedDict()  # key -> list of (coefs, multiplicity)
+        self.factors = OrderedDict()  # key -> coefs of an irreducible factor
+        self.lock = threading.Lock()
+        self.db = None
+        if db_path:
+            self.db = sqlite3.connect(db_path, check_same_thread=False)
+            self.db.execute(
+                "CREATE TABLE IF NOT EXISTS results (key TEXT PRIMARY KEY, factors TEXT)"
+            )
+            self.db.execute(
+                "CREATE TABLE IF NOT EXISTS factors (key TEXT PRIMARY KEY, coefs TEXT, degree INTEGER)"
+            )
+            self.db.commit()
+            self._load_factors()
+
+    def _load_factors(self):
+        rows = self.db.execute(
+            "SELECT key, coefs FROM factors ORDER BY degree LIMIT ?", (self.max_factors,)
+        )
+        for key, coefs in rows:
+            self.factors[key] = json.loads(coefs)
+
+    @staticmethod
+    def _touch(store, key, value, cap):
+        store[key] = value
+        store.move_to_end(key)
+        while len(store) > cap:
+            store.popitem(last=False)
+
+    def get(self, coefs):
+        """Return the cached factorization [(coefs, multiplicity), ...] or None."""
+        key = poly_key(coefs)
+        with self.lock:
+            if key in self.results:
+                self.results.move_to_end(key)
+                return self.results[key]
+            if self.db is None:
+                return None
+            row = self.db.execute(
+                "SELECT factors FROM results WHERE key = ?", (key,)
+            ).fetchone()
+            if row is None:
+                return None
+            result = [(c, m) for c, m in json.loads(row[0])]
+            self._touch(self.results, key, result, self.max_entries)
+            return result
+
+    def put(self, coefs, result):
+        """Store a full factorization and remember its (irreducible) factors."""
+        key = poly_key(coefs)
+        result = [(canonical(c), m) for c, m in result]
+        with self.lock:
+            self._touch(self.results, key, result, self.max_entries)
+            for c, _ in result:
+                if len(c) > 1:
+                    self._touch(self.factors, poly_key(c), c, self.max_factors)
+            if self.db is not None:
+                self.db.execute(
+                    "INSERT OR REPLACE INTO results VALUES (?, ?)", (key, json.dumps(result))
+                )
+                self.db.executemany(
+                    "INSERT OR IGNORE INTO factors VALUES (?, ?, ?)",
+                    [(poly_key(c), json.dumps(c), len(c) - 1) for c, _ in result if len(c) > 1],
+                )
+                self.db.commit()
+
+    def trial_divide(self, coefs):
+        """Divide out every cached irreducible factor, as often as it divides.
+        Returns (found, cofactor) with found a list of (coefs, multiplicity)."""
+        cofactor = canonical(coefs)
+        with self.lock:
+            known = sorted(self.factors.values(), key=len)
+        found = []
+        for f in known:
+            if len(f) > len(cofactor):
+                break
+            mult = 0
+            q = exact_divide(cofactor, f)
+            while q is not None:
+                mult += 1
+                cofactor = q
+                q = exact_divide(cofactor, f) if len(f) <= len(cofactor) else None
+            if mult > 0:
+                found.append((f, mult))
+                with self.lock:
+                    if poly_key(f) in self.factors:
+                        self.factors.move_to_end(poly_key(f))
+        return found, cofactor
@@ -0,0 +1,203 @@
+"""
+Asynchronous factorization jobs for the API.
+
+Each job runs lll_factor as an asyncio subprocess, so a long factorization never
+blocks the event loop. At most max_workers jobs run at once (the rest wait in
+the queue), each with a CPU time limit, and progress events printed by
+lll_factor -progress are collected so that clients can poll or stream them.
+"""
+
+import asyncio
+import json
+import resource
+import signal
+import uuid
+from collections import OrderedDict
+
+PROGRESS_PREFIX = "progress "
+
+
+class QueueFullError(Exception):
+    pass
+
+
+class ProcessError(Exception):
+    def __init__(self, detail, stdout=""):
+        self.detail = detail
+        self.stdout = stdout
+        super().__init__(detail)
+
+
+def cpu_limiter(seconds):
+    """preexec_fn setting the CPU time limit of the child process."""
+
+    def set_limit():
+        resource.setrlimit(resource.RLIMIT_CPU, (seconds, seconds + 1))
+
+    return set_limit
+
+
+async def run_command(command, cpu_limit=None, on_event=None, on_start=None):
+    """Run command without blocking the event loop.
+    Progress lines on stderr are passed to on_event, the rest is kept as error detail.
+    Returns stdout, raises ProcessError on failure. If the awaiting task is cancelled
+    (e.g. the client of a /factor request disconnected), the process is killed first."""
+    proc = await asyncio.create_subprocess_exec(
+        *command,
+        stdout=asyncio.subprocess.PIPE,
+        stderr=asyncio.subprocess.PIPE,
+        preexec_fn=cpu_limiter(cpu_limit) if cpu_limit else None,
+    )
+    if on_start is not None:
+        on_start(proc)
+
+    errors = []
+
+    async def read_stderr():
+        async for line in proc.stderr:
+            line = line.decode("utf-8")
+            if line.startswith(PROGRESS_PREFIX):
+                if on_event is not None:
+                    on_event(json.loads(line[len(PROGRESS_PREFIX) :]))
+            else:
+                errors.append(line)
+
+    try:
+        stdout, _ = await asyncio.gather(proc.stdout.read(), read_stderr())
+        exit_code = await proc.wait()
+    except asyncio.CancelledError:
+        try:
+            proc.kill()
+        except ProcessLookupError:
+            pass  # already exited
+        await proc.wait()
+        raise
+    stdout = stdout.decode("utf-8")
+
+    if cpu_limit and exit_code in (-signal.SIGXCPU, -signal.SIGKILL):
+        raise ProcessError("CPU time limit exceeded", stdout)
+    if exit_code != 0:
+        raise ProcessError("".join(errors), stdout)
+    return stdout
+
+
+class Job:
+    def __init__(self, poly, command):
+        self.id = uuid.uuid4().hex
+        self.poly = poly
+        self.command = command
+        self.status = "queued"
+        self.events = []
+        self.result = None
+        self.error = None
+        self.proc = None
+        self.task = None
+        self.changed = asyncio.Condition()
+
+    @property
+    def finished(self):
+        return self.status in ("done", "failed", "cancelled")
+
+    def summary(self):
+        return {
+            "id": self.id,
+            "status": self.status,
+            "events": len(self.events),
+            "progress": self.events[-1] if self.events else None,
+            "result": self.result,
+            "error": self.error,
+        }
+
+    async def notify(self):
+        async with self.changed:
+            self.changed.notify_all()
+
+    def add_event(self, event):
+        self.events.append(event)
+        asyncio.get_running_loop().create_task(self.notify())
+
+    async def stream(self):
+        """Yield progress events as they arrive, then the final summary."""
+        i = 0
+        while True:
+            async with self.changed:
+                await self.changed.wait_for(lambda: i < len(self.events) or self.finished)
+            while i < len(self.events):
+                yield self.events[i]
+                i += 1
+            if self.finished:
+                yield self.summary()
+                return
+
+
+class JobManager:
+    def __init__(self, max_workers=2, max_jobs=64, cpu_limit=60, parse=None, on_result=None):
+        """parse turns lll_factor's stdout into the job result;
+        on_result(poly, parsed) is called for each successful job (e.g. to fill a cache)."""
+        self.workers = asyncio.Semaphore(max_workers)
+        self.max_jobs = max_jobs
+        self.cpu_limit = cpu_limit
+        self.parse = parse
+        self.on_result = on_result
+        self.jobs = OrderedDict()
+
+    def _forget_finished(self):
+        # keep the job table bounded; oldest finished jobs go first
+        for job_id in list(self.jobs):
+            if len(self.jobs) < self.max_jobs:
+                break
+            if self.jobs[job_id].finished:
+                del self.jobs[job_id]
+
+    def submit(self, poly, command):
+        self._forget_finished()
+        if len(self.jobs) >= self.max_jobs:
+            raise QueueFullError("Too many jobs, try again later.")
+        job = Job(poly, command)
+        self.jobs[job.id] = job
+        job.task = asyncio.get_running_loop().create_task(self._run(job))
+        return job
+
+    def get(self, job_id):
+        return self.jobs.get(job_id)
+
+    async def _run(self, job):
+        try:
+            async with self.workers:
+                job.status = "running"
+                await job.notify()
+
+                def started(proc):
+                    job.proc = proc
+
+                out = await run_command(
+                    job.command, self.cpu_limit, on_event=job.add_event, on_start=started
+                )
+                parsed = self.parse(out) if self.parse else out
+                if self.on_result is not None:
+                    self.on_result(job.poly, parsed)
+                job.result = {k: v for k, v in parsed.items() if k != "coefficients"}
+                job.status = "done"
+        except asyncio.CancelledError:
+            job.status = "cancelled"
+        except ProcessError as e:
+            job.error = e.detail
+            job.status = "failed"
+        finally:
+            job.proc = None
+            await job.notify()
+
+    async def cancel(self, job_id):
+        job = self.jobs.get(job_id)
+        if job is None or job.finished:
+            return job
+        if job.proc is not None and job.proc.returncode is None:
+            job.proc.kill()
+        job.task.cancel()
+        try:
+            await job.task
+        except asyncio.CancelledError:
+            pass
+        job.status = "cancelled"
+        await job.notify()
+        return job
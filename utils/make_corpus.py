@@ -0,0 +1,173 @@
+"""
+Generate the benchmark corpus read by utils/bench.py.
+
+Categories:
+    random        products of random monic irreducibles, by factor degree and coefficient height
+    cyclotomic    products of distinct cyclotomic polynomials
+    swinnerton    Swinnerton-Dyer polynomials (irreducible, but split modulo every prime)
+    multiplicity  products of small irreducibles raised to powers 2-4 (like the README example)
+
+Output is a csv file with columns: name, category, degree, coefficients (comma separated, lowest degree first).
+The same seed always gives the same corpus.
+"""
+
+import argparse
+import csv
+import random
+import sys
+from math import comb
+
+from utils.make_factor_db import cyclotomics, small_irreducibles
+
+PRIMES = [2, 3, 5, 7, 11, 13]
+
+
+def multiply(p, q):
+    r = [0] * (len(p) + len(q) - 1)
+    for i, a in enumerate(p):
+        if a:
+            for j, b in enumerate(q):
+                r[i + j] += a * b
+    return r
+
+
+def product(polys):
+    r = [1]
+    for p in polys:
+        r = multiply(r, p)
+    return r
+
+
+# arithmetic in F_p[x], lowest degree first, no trailing zeros
+def trim(p):
+    while p and p[-1] == 0:
+        p.pop()
+    return p
+
+
+def mulmod(a, b, f, p):
+    r = trim([c % p for c in multiply(a, b)]) if a and b else []
+    return remainder(r, f, p)
+
+
+def remainder(a, f, p):
+    a = list(a)
+    inv = pow(f[-1], -1, p)
+    while len(a) >= len(f):
+        c = a[-1] * inv % p
+        shift = len(a) - len(f)
+        for j, b in enumerate(f):
+            a[shift + j] = (a[shift + j] - c * b) % p
+        trim(a)
+    return a
+
+
+def gcd_mod(a, b, p):
+    a, b = trim([c % p for c in a]), trim([c % p for c in b])
+    while b:
+        a, b = b, remainder(a, b, p)
+    return a
+
+
+def irreducible_mod(f, p):
+    """Ben-Or test: f (monic) is irreducible mod p iff gcd(x^(p^i) - x, f) = 1 for i <= deg/2."""
+    f = [c % p for c in f]
+    if f[-1] == 0:
+        return False
+    xp = [0, 1]
+    for _ in range((len(f) - 1) // 2):
+        # xp <- xp^p mod f
+        r, base, e = [1], xp, p
+        while e:
+            if e & 1:
+                r = mulmod(r, base, f, p)
+            base = mulmod(base, base, f, p)
+            e >>= 1
+        xp = r
+        diff = list(xp) + [0] * max(0, 2 - len(xp))
+        diff[1] -= 1
+        if len(gcd_mod(diff, f, p)) > 1:
+            return False
+    return True
+
+
+def random_irreducible(rng, degree, height):
+    """Random monic polynomial of given degree and height that is irreducible mod some small prime
+    (hence irreducible over Z)."""
+    while True:
+        f = [rng.randint(-height, height) for _ in range(degree)] + [1]
+        if f[0] != 0 and any(irreducible_mod(f, p) for p in PRIMES):
+            return f
+
+
+def swinnerton_dyer(n):
+    """prod (x +- sqrt(2) +- sqrt(3) +- ... +- sqrt(p_n)), built one prime at a time from the
+    norm f(x+sqrt(p)) f(x-sqrt(p)) = A^2 - p B^2 where f(x+sqrt(p)) = A + sqrt(p) B."""
+    f = [0, 1]
+    for p in PRIMES[:n]:
+        a = [0] * len(f)
+        b = [0] * len(f)
+        for k, c in enumerate(f):
+            for j in range(k + 1):
+                term = c * comb(k, j) * p ** (j // 2)
+                if j % 2 == 0:
+                    a[k - j] += term
+                else:
+                    b[k - j] += term
+        a2 = multiply(a, a)
+        pb2 = [p * c for c in multiply(b, b)]
+        f = trim([x - y for x, y in zip(a2, pb2)])
+    return f
+
+
+def corpus(rng, args):
+    entries = []
+
+    for degree in args.degrees:
+        for height in args.heights:
+            for k in range(args.count):
+                factors = [random_irreducible(rng, degree, height) for _ in range(args.factors)]
+                entries.append((f"random_d{degree}_h{height}_{k}", "random", product(factors)))
+
+    phi = cyclotomics(args.max_order)
+    for k in range(args.count * 2):
+        orders = rng.sample(range(1, args.max_order + 1), args.factors)
+        name = "cyclotomic_" + "_".join(map(str, sorted(orders)))
+        entries.append((name, "cyclotomic", product(phi[n - 1] for n in orders)))
+
+    for n in range(1, args.swinnerton + 1):
+        entries.append((f"swinnerton_{n}", "swinnerton", swinnerton_dyer(n)))
+
+    small = [p for p in small_irreducibles(3, 2) if len(p) > 1]
+    for k in range(args.count * 2):
+        factors = []
+        for f in rng.sample(small, args.factors):
+            factors += [f] * rng.randint(2, 4)
+        entries.append((f"multiplicity_{k}", "multiplicity", product(factors)))
+
+    return entries
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("output")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--count", type=int, default=3, help="polynomials per setting")
+    parser.add_argument("--factors", type=int, default=3, help="factors per product")
+    parser.add_argument("--degrees", type=int, nargs="+", default=[2, 3, 5])
+    parser.add_argument("--heights", type=int, nargs="+", default=[5, 50])
+    parser.add_argument("--max-order", type=int, default=30)
+    parser.add_argument("--swinnerton", type=int, default=3, help="largest number of square roots")
+    args = parser.parse_args()
+
+    entries = corpus(random.Random(args.seed), args)
+    with open(args.output, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["name", "category", "degree", "coefficients"])
+        for name, category, p in entries:
+            writer.writerow([name, category, len(p) - 1, ",".join(map(str, p))])
+    print(f"{len(entries)} polynomials written to {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
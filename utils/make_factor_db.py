@@ -0,0 +1,102 @@
+"""
+Generate the factor database read by lll_factor -db <file>.
+
+Contents: all cyclotomic polynomials up to a given order, and all monic
+irreducibles of degree 1-3 up to a given height (max |coefficient|).
+
+Format (all integers little-endian):
+    "PFDB", u32 count, then for each entry: i32 degree, (degree+1) i32 coefficients (lowest degree first)
+Entries are sorted by degree.
+"""
+
+import argparse
+import struct
+import sys
+from itertools import product
+
+
+def divide(p, d):
+    """Quotient of p by monic d (exact division assumed)."""
+    p = list(p)
+    m = len(d) - 1
+    q = [0] * (len(p) - m)
+    for i in range(len(q) - 1, -1, -1):
+        q[i] = p[i + m]
+        for j in range(m + 1):
+            p[i + j] -= q[i] * d[j]
+    return q
+
+
+def cyclotomics(max_order):
+    phi = {}
+    for n in range(1, max_order + 1):
+        p = [-1] + [0] * (n - 1) + [1]  # x^n - 1
+        for d in range(1, n):
+            if n % d == 0:
+                p = divide(p, phi[d])
+        phi[n] = p
+    return list(phi.values())
+
+
+def has_integer_root(p):
+    c = p[0]
+    if c == 0:
+        return True
+    for r in range(1, abs(c) + 1):
+        if abs(c) % r == 0:
+            for s in (r, -r):
+                if sum(a * s**i for i, a in enumerate(p)) == 0:
+                    return True
+    return False
+
+
+def is_square(n):
+    if n < 0:
+        return False
+    r = int(n**0.5)
+    while r * r > n:
+        r -= 1
+    while (r + 1) * (r + 1) <= n:
+        r += 1
+    return r * r == n
+
+
+def small_irreducibles(height, cubic_height):
+    polys = [[c, 1] for c in range(-height, height + 1)]
+    for c, b in product(range(-height, height + 1), repeat=2):
+        # a monic quadratic is reducible iff its discriminant is a square
+        if not is_square(b * b - 4 * c):
+            polys.append([c, b, 1])
+    for c, b, a in product(range(-cubic_height, cubic_height + 1), repeat=3):
+        # a monic cubic is reducible iff it has an integer root
+        if not has_integer_root([c, b, a, 1]):
+            polys.append([c, b, a, 1])
+    return polys
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("output")
+    parser.add_argument("--max-order", type=int, default=200)
+    parser.add_argument("--height", type=int, default=10)
+    parser.add_argument("--cubic-height", type=int, default=5)
+    args = parser.parse_args()
+
+    seen = set()
+    entries = []
+    for p in cyclotomics(args.max_order) + small_irreducibles(args.height, args.cubic_height):
+        if tuple(p) not in seen:
+            seen.add(tuple(p))
+            entries.append(p)
+    entries.sort(key=len)
+
+    with open(args.output, "wb") as f:
+        f.write(b"PFDB")
+        f.write(struct.pack("<I", len(entries)))
+        for p in entries:
+            f.write(struct.pack(f"<i{len(p)}i", len(p) - 1, *p))
+    print(f"{len(entries)} entries written to {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
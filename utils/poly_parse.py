@@ -3,13 +3,8 @@ import re
 
 
 class PolynomialConstraintError(Exception):
-    def __init__(self, max_degree, lc):
-        if lc != 1:
-            self.message = f"Polynomial must be monic."
-        if max_degree is not None:
-            self.message = (
-                f"Polynomial degree must not exceed {max_degree} and must be monic."
-            )
+    def __init__(self, max_degree):
+        self.message = f"Polynomial degree must not exceed {max_degree}."
         super().__init__(self.message)
 
 
@@ -25,7 +20,7 @@ def parse_poly(polystr, max_deg=None):
     e.g. x^4-1  ->  -1,0,0,1
     """
     polystr = polystr.replace(" ", "").lower()
-    L = polystr.replace("-", "+-").split("+")
+    L = polystr.replace("-", "+-").lstrip("+").split("+")
     degree = 0
 
     # regularize terms
@@ -70,15 +65,33 @@ def parse_poly(polystr, max_deg=None):
             else:
                 raise PolynomialFormatError()
 
-    if coefs[-1] != 1:
-        raise PolynomialConstraintError(None, coefs[-1])
     if max_deg is not None and degree > max_deg:
-        raise PolynomialConstraintError(max_deg, coefs[-1])
+        raise PolynomialConstraintError(max_deg)
 
     rstring = ",".join(map(str, coefs))
     return rstring
 
 
+def format_poly(coefs):
+    """
+    inverse of parse_poly, in the format used by print_poly in lll_functions.h
+    e.g. [-1,0,0,1]  ->  -1 + x^3
+    """
+    rstring = ""
+    if len(coefs) > 0 and coefs[0] != 0:
+        rstring = str(coefs[0])
+    for i, c in enumerate(coefs[1:], start=1):
+        if c == 0:
+            continue
+        mono = "x" if i == 1 else f"x^{i}"
+        if abs(c) != 1:
+            mono = f"{abs(c)}{mono}"
+        if rstring:
+            rstring += (" + " if c > 0 else " - ") + mono
+        else:
+            rstring = mono if c > 0 else "-" + mono
+    return rstring
+
 if __name__ == "__main__":
 
     argc = len(sys.argv)
@@ -1,4 +1,6 @@
 import re
+import json
+from utils.poly_parse import format_poly
 
 
 def parse_output(out):
@@ -15,6 +17,83 @@ def parse_output(out):
     return rval
 
 
+def parse_output_json(out):
+    """Parse the -json output of lll_factor.
+    Keys in return: factors (list), time (str), coefficients (list of (coefs, multiplicity)),
+    complete (bool), cofactor (str, the unfactored part if not complete)
+    """
+    data = json.loads(out)
+    coefficients = [
+        ([int(c) for c in f["coefficients"]], f["multiplicity"]) for f in data["factors"]
+    ]
+    factors = [format_factor(coefs, mult) for coefs, mult in coefficients]
+
+    cofactor = None
+    if "cofactor" in data:
+        cofactor = format_factor([int(c) for c in data["cofactor"]["coefficients"]])
+
+    rval = {
+        "time": f"{data.get('time_ms', 0)}ms",
+        "factors": factors,
+        "coefficients": coefficients,
+        "complete": data.get("complete", True),
+        "cofactor": cofactor,
+    }
+    return rval
+
+
+def parse_output_bin(out):
+    """Parse the -obin output of lll_factor (bytes), into the same keys as parse_output_json.
+    The format: u32 factor count, then per factor a u32 multiplicity and a binary polynomial
+    (u32 coefficient count, each coefficient an i32 signed word count and that many u64 words,
+    least significant first), then u32 1 if complete, or u32 0 and the cofactor as a factor."""
+    pos = 0
+
+    def u32():
+        nonlocal pos
+        pos += 4
+        return int.from_bytes(out[pos - 4 : pos], "little")
+
+    def poly():
+        nonlocal pos
+        coefs = []
+        for _ in range(u32()):
+            n = int.from_bytes(out[pos : pos + 4], "little", signed=True)
+            pos += 4
+            c = int.from_bytes(out[pos : pos + 8 * abs(n)], "little")
+            pos += 8 * abs(n)
+            coefs.append(-c if n < 0 else c)
+        return coefs
+
+    def factor():
+        multiplicity = u32()
+        return poly(), multiplicity
+
+    coefficients = [factor() for _ in range(u32())]
+    complete = u32() == 1
+    cofactor = None
+    if not complete:
+        cofactor_coefs, cofactor_multiplicity = factor()
+        cofactor = format_factor(cofactor_coefs, cofactor_multiplicity)
+
+    rval = {
+        "time": "0ms",
+        "factors": [format_factor(coefs, mult) for coefs, mult in coefficients],
+        "coefficients": coefficients,
+        "complete": complete,
+        "cofactor": cofactor,
+    }
+    return rval
+
+
+def format_factor(coefs, multiplicity=1):
+    """Format a factor the same way lll_factor prints it, e.g. (1 + x)^3"""
+    rval = f"({format_poly(coefs)})"
+    if multiplicity > 1:
+        rval += f"^{multiplicity}"
+    return rval
+
+
 def parse_output_html(out, verbose='on', failed=False):
     """Parse the verbose output of lll_factor to an html string."""
     font_family = "Courier New"
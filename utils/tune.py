@@ -0,0 +1,98 @@
+"""
+Tune the precision (-p) and LLL parameter (-d) of lll_factor per input class.
+
+Every polynomial of the corpus (see utils/make_corpus.py) is factored with each
+combination of -p and -d. Polynomials are grouped by degree and height (bits of the
+largest coefficient); for each group the setting with the best success rate, and
+among those the lowest mean time to a correct factorization, is written to a table
+that lll_factor reads with -tune <file> (or $POLY_FACTOR_TUNE_TABLE) whenever -p or
+-d are not given.
+
+Table format (see src/tune_table.h): one row per group, from small to large,
+    <max degree> <max height bits> <precision> <delta>
+with -1 for an unbounded column.
+
+Usage: python3 -m utils.tune data/corpus.csv data/tune_table.txt [-p 64 128 256] [-d 0.5 0.75 0.99]
+"""
+
+import argparse
+import bisect
+import csv
+import sys
+from collections import defaultdict
+
+from utils.bench import run_one
+
+
+def group_of(bound_list, value):
+    """Index of the first bound >= value (len(bound_list) if none)."""
+    return bisect.bisect_left(bound_list, value)
+
+
+def height_bits(coefs):
+    return max(abs(c) for c in coefs).bit_length()
+
+
+def best_setting(results):
+    """results: {(precision, delta): [(success, wall_ms), ...]} -> best (precision, delta) or None."""
+
+    def score(item):
+        (precision, delta), runs = item
+        ok = [t for s, t in runs if s]
+        rate = len(ok) / len(runs)
+        mean = sum(ok) / len(ok) if ok else float("inf")
+        return (-rate, mean, precision, delta)
+
+    best = min(results.items(), key=score, default=None)
+    if best is None or not any(s for s, _ in best[1]):
+        return None
+    return best[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("corpus")
+    parser.add_argument("output")
+    parser.add_argument("-p", "--precisions", type=int, nargs="+", default=[64, 128, 256])
+    parser.add_argument("-d", "--deltas", type=float, nargs="+", default=[0.5, 0.75, 0.99])
+    parser.add_argument("--degree-bounds", type=int, nargs="+", default=[8, 16, 32])
+    parser.add_argument("--height-bits", type=int, nargs="+", default=[8, 32])
+    parser.add_argument("--binary", default="bin/lll_factor")
+    parser.add_argument("--timeout", type=int, default=20000, help="per run, in ms")
+    args = parser.parse_args()
+
+    degree_bounds = sorted(args.degree_bounds)
+    bit_bounds = sorted(args.height_bits)
+
+    with open(args.corpus, newline="") as f:
+        corpus = list(csv.DictReader(f))
+
+    # (degree group, height group) -> (precision, delta) -> [(success, wall_ms)]
+    results = defaultdict(lambda: defaultdict(list))
+    for entry in corpus:
+        coefs = [int(c) for c in entry["coefficients"].split(",")]
+        group = (group_of(degree_bounds, len(coefs) - 1), group_of(bit_bounds, height_bits(coefs)))
+        for precision in args.precisions:
+            for delta in args.deltas:
+                row = run_one(args.binary, coefs, precision, delta, args.timeout, [])
+                results[group][(precision, delta)].append((row["success"], row["wall_ms"]))
+        print(f"{entry['name']}: done", file=sys.stderr)
+
+    with open(args.output, "w") as f:
+        f.write(f"# generated by utils/tune.py from {args.corpus}\n")
+        f.write("# max_degree max_height_bits precision delta\n")
+        for g_deg in range(len(degree_bounds) + 1):
+            for g_bits in range(len(bit_bounds) + 1):
+                if (g_deg, g_bits) not in results:
+                    continue
+                best = best_setting(results[(g_deg, g_bits)])
+                if best is None:
+                    continue
+                max_degree = degree_bounds[g_deg] if g_deg < len(degree_bounds) else -1
+                max_bits = bit_bounds[g_bits] if g_bits < len(bit_bounds) else -1
+                f.write(f"{max_degree} {max_bits} {best[0]} {best[1]}\n")
+    print(f"table written to {args.output}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()